@@ -15,6 +15,64 @@
 #include "aes_decrypt.h"
 
 
+#if AES_WORD_STATE == 1U
+/*
+ * Word-state helpers: a column is one uint32_t with row r in byte r.
+ */
+static inline uint32_t load_word(const uint8_t *p);
+static inline uint32_t load_word(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8U) | ((uint32_t)p[2] << 16U) | ((uint32_t)p[3] << 24U);
+}
+
+static inline void store_word(uint8_t *p, uint32_t v);
+static inline void store_word(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8U);
+    p[2] = (uint8_t)(v >> 16U);
+    p[3] = (uint8_t)(v >> 24U);
+}
+
+static inline uint32_t rotr32(uint32_t v, uint32_t n);
+static inline uint32_t rotr32(uint32_t v, uint32_t n) {
+    return (v >> n) | (v << (32U - n));
+}
+
+/**
+ * @purpose:    mul2 on the four bytes of a word at once, without a branch
+ */
+static inline uint32_t xtime_word(uint32_t w);
+static inline uint32_t xtime_word(uint32_t w) {
+    return ((w & 0x7f7f7f7fU) << 1U) ^ (((w >> 7U) & 0x01010101U) * 0x1bU);
+}
+
+/**
+ * @purpose:    MixColumns on one column word, 02.t ^ rot8(w) ^ rot16(t) with t = w ^ rot8(w),
+ *              rot8 moving row r+1 to row r
+ */
+static inline uint32_t mix_column_word(uint32_t w);
+static inline uint32_t mix_column_word(uint32_t w) {
+    uint32_t r = rotr32(w, 8U);
+    uint32_t t = w ^ r;
+    return xtime_word(t) ^ r ^ rotr32(t, 16U);
+}
+
+/**
+ * @purpose:    InvMixColumns on one column word: w ^= 04.(w ^ rot16(w)), then MixColumns
+ */
+static inline uint32_t inv_mix_column_word(uint32_t w);
+static inline uint32_t inv_mix_column_word(uint32_t w) {
+    return mix_column_word(w ^ xtime_word(xtime_word(w ^ rotr32(w, 16U))));
+}
+
+/**
+ * @purpose:    InvShiftRows and InvSubBytes in one pass: row r of the output column comes from w_r
+ */
+static inline uint32_t inv_sub_shift_word(const uint8_t *box, uint32_t w0, uint32_t w1, uint32_t w2, uint32_t w3);
+static inline uint32_t inv_sub_shift_word(const uint8_t *box, uint32_t w0, uint32_t w1, uint32_t w2, uint32_t w3) {
+    return (uint32_t)box[w0 & 0xffU] | ((uint32_t)box[(w1 >> 8U) & 0xffU] << 8U)
+         | ((uint32_t)box[(w2 >> 16U) & 0xffU] << 16U) | ((uint32_t)box[(w3 >> 24U) & 0xffU] << 24U);
+}
+#else
 /**
  * https://en.wikipedia.org/wiki/Finite_field_arithmetic
  * Multiply two numbers in the GF(2^8) finite field defined
@@ -24,16 +82,7 @@
  */
 static inline uint8_t mul2(uint8_t a);
 static inline uint8_t mul2(uint8_t a) {
-    uint8_t index;
-    if (a&0x80U)
-    {
-        index = ((uint8_t)(a<<1U)^0x1bU);
-    }
-    else
-    {
-        index = (a<<1U);
-    }
-    return index;
+    return (uint8_t)((uint8_t)(a << 1U) ^ (uint8_t)(((uint32_t)a >> 7U) * 0x1bU));
 }
 /**
  * @purpose:    Inverse ShiftRows
@@ -66,11 +115,17 @@ static void inv_shift_rows(uint8_t *state) {
     *(state+11) = *(state+15);
     *(state+15) = temp;
 }
+#endif
  void aes_decrypt_128( const uint8_t *roundkeys, const uint8_t *ciphertext, uint8_t *plaintext) {
 
+#if AES_WORD_STATE == 1U
+    uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+    uint8_t j;
+#else
     uint8_t tmp[16];
     uint8_t t, u, v;
     uint8_t i, j;
+#endif
     static uint8_t INV_SBOX[256] = {
         0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
         0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
@@ -88,6 +143,38 @@ static void inv_shift_rows(uint8_t *state) {
         0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
         0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
         0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d};
+#if AES_WORD_STATE == 1U
+    roundkeys += 160;
+
+    /* first round*/
+    s0 = load_word(&ciphertext[0])  ^ load_word(&roundkeys[0]);
+    s1 = load_word(&ciphertext[4])  ^ load_word(&roundkeys[4]);
+    s2 = load_word(&ciphertext[8])  ^ load_word(&roundkeys[8]);
+    s3 = load_word(&ciphertext[12]) ^ load_word(&roundkeys[12]);
+    t0 = inv_sub_shift_word(INV_SBOX, s0, s3, s2, s1);
+    t1 = inv_sub_shift_word(INV_SBOX, s1, s0, s3, s2);
+    t2 = inv_sub_shift_word(INV_SBOX, s2, s1, s0, s3);
+    t3 = inv_sub_shift_word(INV_SBOX, s3, s2, s1, s0);
+
+    for (j = 1U; j < AES_ROUNDS; ++j) {
+        roundkeys -= 16;
+        s0 = inv_mix_column_word(t0 ^ load_word(&roundkeys[0]));
+        s1 = inv_mix_column_word(t1 ^ load_word(&roundkeys[4]));
+        s2 = inv_mix_column_word(t2 ^ load_word(&roundkeys[8]));
+        s3 = inv_mix_column_word(t3 ^ load_word(&roundkeys[12]));
+        t0 = inv_sub_shift_word(INV_SBOX, s0, s3, s2, s1);
+        t1 = inv_sub_shift_word(INV_SBOX, s1, s0, s3, s2);
+        t2 = inv_sub_shift_word(INV_SBOX, s2, s1, s0, s3);
+        t3 = inv_sub_shift_word(INV_SBOX, s3, s2, s1, s0);
+    }
+
+    /* last AddRoundKey*/
+    roundkeys -= 16;
+    store_word(&plaintext[0],  t0 ^ load_word(&roundkeys[0]));
+    store_word(&plaintext[4],  t1 ^ load_word(&roundkeys[4]));
+    store_word(&plaintext[8],  t2 ^ load_word(&roundkeys[8]));
+    store_word(&plaintext[12], t3 ^ load_word(&roundkeys[12]));
+#else
     roundkeys += 160;
 
     /* first round*/
@@ -145,4 +232,5 @@ static void inv_shift_rows(uint8_t *state) {
     for ( i = 0U; i < AES_BLOCK_SIZE; ++i ) {
         *(plaintext+i) ^= *(roundkeys+i);
     }
+#endif
 }
@@ -35,6 +35,56 @@
     0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16};
 
 
+#if AES_WORD_STATE == 1U
+/*
+ * Word-state helpers: a column is one uint32_t with row r in byte r.
+ */
+static inline uint32_t load_word(const uint8_t *p);
+static inline uint32_t load_word(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8U) | ((uint32_t)p[2] << 16U) | ((uint32_t)p[3] << 24U);
+}
+
+static inline void store_word(uint8_t *p, uint32_t v);
+static inline void store_word(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8U);
+    p[2] = (uint8_t)(v >> 16U);
+    p[3] = (uint8_t)(v >> 24U);
+}
+
+static inline uint32_t rotr32(uint32_t v, uint32_t n);
+static inline uint32_t rotr32(uint32_t v, uint32_t n) {
+    return (v >> n) | (v << (32U - n));
+}
+
+/**
+ * @purpose:    mul2 on the four bytes of a word at once, without a branch
+ */
+static inline uint32_t xtime_word(uint32_t w);
+static inline uint32_t xtime_word(uint32_t w) {
+    return ((w & 0x7f7f7f7fU) << 1U) ^ (((w >> 7U) & 0x01010101U) * 0x1bU);
+}
+
+/**
+ * @purpose:    MixColumns on one column word, 02.t ^ rot8(w) ^ rot16(t) with t = w ^ rot8(w),
+ *              rot8 moving row r+1 to row r
+ */
+static inline uint32_t mix_column_word(uint32_t w);
+static inline uint32_t mix_column_word(uint32_t w) {
+    uint32_t r = rotr32(w, 8U);
+    uint32_t t = w ^ r;
+    return xtime_word(t) ^ r ^ rotr32(t, 16U);
+}
+
+/**
+ * @purpose:    SubBytes and ShiftRows in one pass: row r of the output column comes from w_r
+ */
+static inline uint32_t sub_shift_word(uint32_t w0, uint32_t w1, uint32_t w2, uint32_t w3);
+static inline uint32_t sub_shift_word(uint32_t w0, uint32_t w1, uint32_t w2, uint32_t w3) {
+    return (uint32_t)SBOX[w0 & 0xffU] | ((uint32_t)SBOX[(w1 >> 8U) & 0xffU] << 8U)
+         | ((uint32_t)SBOX[(w2 >> 16U) & 0xffU] << 16U) | ((uint32_t)SBOX[(w3 >> 24U) & 0xffU] << 24U);
+}
+#else
 /**
  * https://en.wikipedia.org/wiki/Finite_field_arithmetic
  * Multiply two numbers in the GF(2^8) finite field defined
@@ -44,16 +94,7 @@
  */
   static inline uint8_t mul2(uint8_t a);
 static inline uint8_t mul2(uint8_t a) {
-    uint8_t index;
-       if (a&0x80U)
-       {
-           index = ((uint8_t)(a<<1U)^0x1bU);
-       }
-       else
-       {
-           index = (a<<1U);
-       }
-       return index;
+    return (uint8_t)((uint8_t)(a << 1U) ^ (uint8_t)(((uint32_t)a >> 7U) * 0x1bU));
 }
 /**
  * @purpose:    ShiftRows
@@ -87,7 +128,38 @@ static void shift_rows(uint8_t *state) {
     *(state+3)  = temp;
 }
 
+#endif
  void aes_encrypt_128( const uint8_t *roundkeys, const uint8_t *plaintext,  uint8_t *ciphertext) {
+#if AES_WORD_STATE == 1U
+    uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+    uint8_t j;
+
+    /* first AddRoundKey*/
+    s0 = load_word(&plaintext[0])  ^ load_word(&roundkeys[0]);
+    s1 = load_word(&plaintext[4])  ^ load_word(&roundkeys[4]);
+    s2 = load_word(&plaintext[8])  ^ load_word(&roundkeys[8]);
+    s3 = load_word(&plaintext[12]) ^ load_word(&roundkeys[12]);
+
+    /* 9 rounds*/
+    for (j = 1U; j < AES_ROUNDS; ++j) {
+        roundkeys += 16;
+        t0 = sub_shift_word(s0, s1, s2, s3);
+        t1 = sub_shift_word(s1, s2, s3, s0);
+        t2 = sub_shift_word(s2, s3, s0, s1);
+        t3 = sub_shift_word(s3, s0, s1, s2);
+        s0 = mix_column_word(t0) ^ load_word(&roundkeys[0]);
+        s1 = mix_column_word(t1) ^ load_word(&roundkeys[4]);
+        s2 = mix_column_word(t2) ^ load_word(&roundkeys[8]);
+        s3 = mix_column_word(t3) ^ load_word(&roundkeys[12]);
+    }
+
+    /* last round*/
+    roundkeys += 16;
+    store_word(&ciphertext[0],  sub_shift_word(s0, s1, s2, s3) ^ load_word(&roundkeys[0]));
+    store_word(&ciphertext[4],  sub_shift_word(s1, s2, s3, s0) ^ load_word(&roundkeys[4]));
+    store_word(&ciphertext[8],  sub_shift_word(s2, s3, s0, s1) ^ load_word(&roundkeys[8]));
+    store_word(&ciphertext[12], sub_shift_word(s3, s0, s1, s2) ^ load_word(&roundkeys[12]));
+#else
 
     uint8_t tmp[16], t;
     uint8_t i, j;
@@ -139,4 +211,5 @@ static void shift_rows(uint8_t *state) {
         roundkeys++;
 
     }
+#endif
 }
@@ -19,6 +19,9 @@ extern uint8_t SBOX[256];
 #define AES_BLOCK_SIZE      16U
 #define AES_ROUNDS          10U  /* 12, 14*/
 #define AES_ROUND_KEY_SIZE  176U /* AES-128 has 10 rounds, and there is a AddRoundKey before first round. (10+1)x16=176.*/
+#ifndef AES_WORD_STATE
+#define AES_WORD_STATE      1U   /* 1: 32-bit column words with SWAR MixColumns, 0: byte-wise rounds*/
+#endif
 /**
  * @purpose:            Encryption. The length of plain and cipher should be one block (16 bytes).
  *                      The plaintext and ciphertext may point to the same memory
@@ -0,0 +1,414 @@
+/*
+ * aes_fixslice.c
+ *
+ * Fixsliced AES-128 for 32-bit targets, two blocks per call.
+ *
+ * The 32 bytes of the two blocks are held as 8 bit planes q[0..7] of 32 bits:
+ * plane b holds bit b of every byte, at position row*8 + column*2 + block.
+ * A byte of a plane is a row, so MixColumns is a word rotation by 8, 16 or 24
+ * bits, and SubBytes is the Boyar-Peralta circuit on the planes. Nothing is
+ * looked up in memory with an index that depends on the data or the key.
+ *
+ * ShiftRows is never done. After j rounds column c of row r sits in column
+ * c + j.r, which MixColumns compensates by also rotating the columns inside
+ * every row byte by j (mod 4). The round keys are stored in the same order,
+ * and a single ShiftRows^2 at the end (encryption) or start (decryption)
+ * puts the state back, as 10 = 2 mod 4.
+ *
+ */
+#include "std_types.h"
+#include "aes_schedule.h"
+#include "aes_fixslice.h"
+
+static inline uint32_t ror32(uint32_t x, uint32_t n);
+static inline uint32_t ror32(uint32_t x, uint32_t n) {
+    return (x >> n) | (x << (32U - n));
+}
+
+/**
+ * @purpose:    Rotate the 4 columns of every row byte right by n, i.e. the bits by 2n.
+ */
+static inline uint32_t ror_columns(uint32_t x, uint8_t n);
+static inline uint32_t ror_columns(uint32_t x, uint8_t n) {
+    static const uint32_t LO[4] = {0xffffffffU, 0x3f3f3f3fU, 0x0f0f0f0fU, 0x03030303U};
+    uint32_t y = x;
+    if (n != 0U) {
+        y = ((x >> (2U * n)) & LO[n]) | ((x << (8U - (2U * n))) & (~LO[n]));
+    }
+    return y;
+}
+
+/**
+ * @purpose:    Exchange the bits selected by m in *a with the bits n positions higher in *b.
+ */
+static inline void swapmove(uint32_t *a, uint32_t *b, uint32_t m, uint32_t n);
+static inline void swapmove(uint32_t *a, uint32_t *b, uint32_t m, uint32_t n) {
+    uint32_t t = ((*b >> n) ^ *a) & m;
+    *a ^= t;
+    *b ^= t << n;
+}
+
+/**
+ * @purpose:    Transpose the 8x8 bit matrix in every byte lane of q[0..7]. Word q[2c+k] being
+ *              column c of block k, plane b comes out in q[b]. It is its own inverse.
+ */
+static void fs_transpose(uint32_t *q);
+static void fs_transpose(uint32_t *q) {
+    swapmove(&q[1], &q[0], 0x55555555U, 1U);
+    swapmove(&q[3], &q[2], 0x55555555U, 1U);
+    swapmove(&q[5], &q[4], 0x55555555U, 1U);
+    swapmove(&q[7], &q[6], 0x55555555U, 1U);
+    swapmove(&q[2], &q[0], 0x33333333U, 2U);
+    swapmove(&q[3], &q[1], 0x33333333U, 2U);
+    swapmove(&q[6], &q[4], 0x33333333U, 2U);
+    swapmove(&q[7], &q[5], 0x33333333U, 2U);
+    swapmove(&q[4], &q[0], 0x0f0f0f0fU, 4U);
+    swapmove(&q[5], &q[1], 0x0f0f0f0fU, 4U);
+    swapmove(&q[6], &q[2], 0x0f0f0f0fU, 4U);
+    swapmove(&q[7], &q[3], 0x0f0f0f0fU, 4U);
+}
+
+static void fs_pack(uint32_t *q, const uint8_t *in);
+static void fs_pack(uint32_t *q, const uint8_t *in) {
+    uint8_t i;
+    /* q[2c+k] = column c of block k, row 0 in the low byte*/
+    for (i = 0U; i < 4U; ++i) {
+        q[2U*i]      = (uint32_t)in[4U*i]         | ((uint32_t)in[(4U*i)+1U] << 8U)
+                     | ((uint32_t)in[(4U*i)+2U] << 16U) | ((uint32_t)in[(4U*i)+3U] << 24U);
+        q[(2U*i)+1U] = (uint32_t)in[(4U*i)+16U]   | ((uint32_t)in[(4U*i)+17U] << 8U)
+                     | ((uint32_t)in[(4U*i)+18U] << 16U) | ((uint32_t)in[(4U*i)+19U] << 24U);
+    }
+    fs_transpose(q);
+}
+
+static void fs_unpack(uint8_t *out, uint32_t *q);
+static void fs_unpack(uint8_t *out, uint32_t *q) {
+    uint8_t i, k;
+    fs_transpose(q);
+    for (i = 0U; i < 4U; ++i) {
+        for (k = 0U; k < 4U; ++k) {
+            out[(4U*i)+k]       = (uint8_t)(q[2U*i] >> (8U*k));
+            out[(4U*i)+k+16U]   = (uint8_t)(q[(2U*i)+1U] >> (8U*k));
+        }
+    }
+}
+
+/**
+ * @purpose:    SubBytes on the planes, Boyar-Peralta circuit (113 gates + 4 NOT).
+ *              x0 is the most significant bit.
+ */
+static void fs_sbox(uint32_t *q);
+static void fs_sbox(uint32_t *q) {
+    uint32_t x0, x1, x2, x3, x4, x5, x6, x7;
+    uint32_t y1, y2, y3, y4, y5, y6, y7, y8, y9, y10, y11, y12, y13, y14, y15;
+    uint32_t y16, y17, y18, y19, y20, y21;
+    uint32_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9, z10, z11, z12, z13, z14, z15, z16, z17;
+    uint32_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15;
+    uint32_t t16, t17, t18, t19, t20, t21, t22, t23, t24, t25, t26, t27, t28, t29, t30, t31;
+    uint32_t t32, t33, t34, t35, t36, t37, t38, t39, t40, t41, t42, t43, t44, t45, t46, t47;
+    uint32_t t48, t49, t50, t51, t52, t53, t54, t55, t56, t57, t58, t59, t60, t61, t62, t63;
+    uint32_t t64, t65, t66, t67;
+    uint32_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9 = x0 ^ x3;
+    y8 = x0 ^ x5;
+    t0 = x1 ^ x2;
+    y1 = t0 ^ x7;
+    y4 = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;
+    y3 = y5 ^ y8;
+    t1 = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6 = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7 = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+    t2 = y12 & y15;
+    t3 = y3 & y6;
+    t4 = t3 ^ t2;
+    t5 = y4 & x7;
+    t6 = t5 ^ t2;
+    t7 = y13 & y16;
+    t8 = y5 & y1;
+    t9 = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15;
+    z1 = t37 & y6;
+    z2 = t33 & x7;
+    z3 = t43 & y16;
+    z4 = t40 & y1;
+    z5 = t29 & y7;
+    z6 = t42 & y11;
+    z7 = t45 & y17;
+    z8 = t41 & y10;
+    z9 = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ (~t62);
+    s7 = t48 ^ (~t60);
+    t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ (~s3);
+    s2 = t55 ^ (~t67);
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+/**
+ * @purpose:    InvSubBytes from the forward circuit:
+ *              S^-1(y) = L^-1(S(L^-1(y ^ 63)) ^ 63), L being the linear part of the affine
+ *              transform, L^-1(y) = y <<< 1 ^ y <<< 3 ^ y <<< 6. ^ 63 flips planes 0, 1, 5 and 6.
+ */
+static void fs_affine_inv(uint32_t *q);
+static void fs_affine_inv(uint32_t *q) {
+    uint32_t y[8];
+    uint8_t k;
+
+    for (k = 0U; k < 8U; ++k) {
+        y[k] = q[k];
+    }
+    for (k = 0U; k < 8U; ++k) {
+        q[k] = y[(k + 7U) & 7U] ^ y[(k + 5U) & 7U] ^ y[(k + 2U) & 7U];
+    }
+}
+
+static void fs_inv_sbox(uint32_t *q);
+static void fs_inv_sbox(uint32_t *q) {
+    q[0] = ~q[0];
+    q[1] = ~q[1];
+    q[5] = ~q[5];
+    q[6] = ~q[6];
+    fs_affine_inv(q);
+    fs_sbox(q);
+    q[0] = ~q[0];
+    q[1] = ~q[1];
+    q[5] = ~q[5];
+    q[6] = ~q[6];
+    fs_affine_inv(q);
+}
+
+/**
+ * @purpose:    MixColumns after n skipped ShiftRows, out = 02.t ^ rot1(a) ^ rot2(t) with
+ *              t = a ^ rot1(a). rotN brings row r+N to row r: a word rotation by 8N, then
+ *              the columns of each row by N.n. Multiplying the planes by 02 only renames
+ *              planes and folds plane 7 into planes 1, 3 and 4.
+ * @par[in]n:   number of skipped ShiftRows, mod 4
+ */
+static void fs_mix_columns(uint32_t *q, uint8_t n);
+static void fs_mix_columns(uint32_t *q, uint8_t n) {
+    uint32_t r, t[8];
+    uint8_t k;
+
+    for (k = 0U; k < 8U; ++k) {
+        r    = ror_columns(ror32(q[k], 8U), n);
+        t[k] = q[k] ^ r;
+        q[k] = r ^ ror_columns(ror32(t[k], 16U), (uint8_t)((2U * n) & 3U));
+    }
+    q[0] ^= t[7];
+    q[1] ^= t[0] ^ t[7];
+    q[2] ^= t[1];
+    q[3] ^= t[2] ^ t[7];
+    q[4] ^= t[3] ^ t[7];
+    q[5] ^= t[4];
+    q[6] ^= t[5];
+    q[7] ^= t[6];
+}
+
+/**
+ * @purpose:    InvMixColumns = MixColumns after a ^= 04.(a ^ rot2(a)), see aes_decrypt.c
+ */
+static void fs_inv_mix_columns(uint32_t *q, uint8_t n);
+static void fs_inv_mix_columns(uint32_t *q, uint8_t n) {
+    uint32_t w[8];
+    uint8_t k;
+
+    for (k = 0U; k < 8U; ++k) {
+        w[k] = q[k] ^ ror_columns(ror32(q[k], 16U), (uint8_t)((2U * n) & 3U));
+    }
+    /* multiply by 04*/
+    q[0] ^= w[6];
+    q[1] ^= w[7] ^ w[6];
+    q[2] ^= w[0] ^ w[7];
+    q[3] ^= w[1] ^ w[6];
+    q[4] ^= w[2] ^ w[7] ^ w[6];
+    q[5] ^= w[3] ^ w[7];
+    q[6] ^= w[4];
+    q[7] ^= w[5];
+    fs_mix_columns(q, n);
+}
+
+/**
+ * @purpose:    ShiftRows^2, the same as its inverse: swaps the column halves of rows 1 and 3.
+ */
+static void fs_shift_rows2(uint32_t *q);
+static void fs_shift_rows2(uint32_t *q) {
+    uint8_t k;
+
+    for (k = 0U; k < 8U; ++k) {
+        q[k] = (q[k] & 0x00ff00ffU) | ((q[k] >> 4U) & 0x0f000f00U) | ((q[k] << 4U) & 0xf000f000U);
+    }
+}
+
+static void fs_add_round_key(uint32_t *q, const uint32_t *fskeys);
+static void fs_add_round_key(uint32_t *q, const uint32_t *fskeys) {
+    uint8_t k;
+
+    for (k = 0U; k < 8U; ++k) {
+        q[k] ^= fskeys[k];
+    }
+}
+
+void aes_fs_key_schedule_128(const uint8_t *key, uint32_t *fskeys) {
+
+    uint8_t roundkeys[AES_ROUND_KEY_SIZE];
+    uint8_t both[2U * AES_BLOCK_SIZE];
+    uint8_t j, i, r, c;
+
+    aes_key_schedule_128(key, roundkeys);
+    for (j = 0U; j <= AES_ROUNDS; ++j) {
+        /* round key j goes where the state is after j skipped ShiftRows, for both blocks*/
+        for (c = 0U; c < 4U; ++c) {
+            for (r = 0U; r < 4U; ++r) {
+                i = (uint8_t)((4U * ((c + (j * r)) & 3U)) + r);
+                both[i]       = roundkeys[(16U * j) + (4U * c) + r];
+                both[i + 16U] = both[i];
+            }
+        }
+        fs_pack(&fskeys[8U * j], both);
+    }
+}
+
+void aes_encrypt_128_fs2(const uint32_t *fskeys, const uint8_t *plaintext, uint8_t *ciphertext) {
+
+    uint32_t q[8];
+    uint8_t j;
+
+    fs_pack(q, plaintext);
+    fs_add_round_key(q, fskeys);
+
+    /* 9 rounds, ShiftRows left out*/
+    for (j = 1U; j < AES_ROUNDS; ++j) {
+        fs_sbox(q);
+        fs_mix_columns(q, (uint8_t)(j & 3U));
+        fs_add_round_key(q, &fskeys[8U * j]);
+    }
+
+    /* last round*/
+    fs_sbox(q);
+    fs_add_round_key(q, &fskeys[8U * AES_ROUNDS]);
+    fs_shift_rows2(q);
+    fs_unpack(ciphertext, q);
+}
+
+void aes_decrypt_128_fs2(const uint32_t *fskeys, const uint8_t *ciphertext, uint8_t *plaintext) {
+
+    uint32_t q[8];
+    uint8_t j;
+
+    fs_pack(q, ciphertext);
+    fs_shift_rows2(q);
+    fs_add_round_key(q, &fskeys[8U * AES_ROUNDS]);
+
+    /* 9 rounds, InvShiftRows left out*/
+    for (j = AES_ROUNDS - 1U; j > 0U; --j) {
+        fs_inv_sbox(q);
+        fs_add_round_key(q, &fskeys[8U * j]);
+        fs_inv_mix_columns(q, (uint8_t)(j & 3U));
+    }
+
+    /* last round*/
+    fs_inv_sbox(q);
+    fs_add_round_key(q, fskeys);
+    fs_unpack(plaintext, q);
+}
@@ -0,0 +1,39 @@
+/*
+ * aes_fixslice.h
+ *
+ * Fixsliced AES-128 on 32-bit words, two blocks per call, constant time.
+ *
+ */
+#ifndef AES_FIXSLICE_H
+#define AES_FIXSLICE_H
+
+
+#define AES_FS_BLOCKS           2U
+#define AES_FS_ROUND_KEY_WORDS  88U /* (10+1) round keys x 8 bit planes.*/
+
+/**
+ * @purpose:            Key schedule for the fixsliced engine. The round keys are bitsliced
+ *                      and stored in the column order each round sees them in.
+ * @par[in]key:         16 bytes of master keys
+ * @par[out]fskeys:     88 words of round keys
+ */
+void aes_fs_key_schedule_128(const uint8_t *key, uint32_t *fskeys);
+
+/**
+ * @purpose:            Encryption of two independent blocks (32 bytes) under the same key.
+ *                      The plaintext and ciphertext may point to the same memory
+ * @par[in]fskeys:      round keys from aes_fs_key_schedule_128
+ * @par[in]plaintext:   2 blocks of plain text
+ * @par[out]ciphertext: 2 blocks of cipher text
+ */
+void aes_encrypt_128_fs2(const uint32_t *fskeys, const uint8_t *plaintext, uint8_t *ciphertext);
+
+/**
+ * @purpose:            Decryption of two independent blocks (32 bytes) under the same key.
+ *                      The ciphertext and plaintext may point to the same memory
+ * @par[in]fskeys:      round keys from aes_fs_key_schedule_128
+ * @par[in]ciphertext:  2 blocks of cipher text
+ * @par[out]plaintext:  2 blocks of plain text
+ */
+void aes_decrypt_128_fs2(const uint32_t *fskeys, const uint8_t *ciphertext, uint8_t *plaintext);
+#endif
@@ -18,6 +18,7 @@
 #include "aes_decrypt.h"
 #include "aes_encrypt.h"
 #include "aes_schedule.h"
+#include "aes_fixslice.h"
 
 uint32_t main(uint32_t argc, const uint8_t * const argv[]);
 uint32_t main(uint32_t argc, const uint8_t * const argv[]) {
@@ -50,6 +51,8 @@ uint32_t main(uint32_t argc, const uint8_t * const argv[]) {
     };
 
     uint8_t roundkeys1[AES_ROUND_KEY_SIZE]={0};
+    uint32_t fskeys1[AES_FS_ROUND_KEY_WORDS]={0};
+    uint8_t blocks1[AES_FS_BLOCKS * AES_BLOCK_SIZE]={0};
 
     /* key schedule*/
     aes_key_schedule_128(key1, roundkeys1);
@@ -68,6 +71,21 @@ uint32_t main(uint32_t argc, const uint8_t * const argv[]) {
         if ( CypherText[i] != plaintext1[i] ) { break; }
     }
 
+    /* fixsliced engine, the same block twice*/
+    aes_fs_key_schedule_128(key1, fskeys1);
+    for (i = 0U; i < AES_BLOCK_SIZE; i++) {
+        blocks1[i] = plaintext1[i];
+        blocks1[i + AES_BLOCK_SIZE] = plaintext1[i];
+    }
+    aes_encrypt_128_fs2(fskeys1, blocks1, blocks1);
+    for (i = 0U; i < AES_BLOCK_SIZE; i++) {
+        if ( (blocks1[i] != const_cipher[i]) || (blocks1[i + AES_BLOCK_SIZE] != const_cipher[i]) ) { break; }
+    }
+    aes_decrypt_128_fs2(fskeys1, blocks1, blocks1);
+    for (i = 0U; i < AES_BLOCK_SIZE; i++) {
+        if ( (blocks1[i] != plaintext1[i]) || (blocks1[i + AES_BLOCK_SIZE] != plaintext1[i]) ) { break; }
+    }
+
     return 0U;
 }
 
@@ -0,0 +1,723 @@
+/*
+ * aes_bench.c
+ *
+ * Host throughput benchmark for the engines in ../test1.
+ * Not part of the AVR project, build it on the host with e.g.
+ *
+ *   gcc -O2 -I../test1 aes_bench.c ../test1/aes_*.c -o aes_bench -lpthread
+ *
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "aes_decrypt.h"
+#include "aes_encrypt.h"
+#include "aes_schedule.h"
+#include "aes_ttable.h"
+#include "aes_aesni.h"
+#include "aes_bitslice.h"
+#include "aes_vperm.h"
+#include "aes_engine.h"
+#include "aes_gf.h"
+#include "aes_key.h"
+#include "aes_keycache.h"
+#include "aes_keystore.h"
+#include "aes_keyarena.h"
+#include "aes_ecb.h"
+#include "aes_ctr.h"
+#include "aes_ctr_ring.h"
+
+#if AES_HAVE_AESNI
+#include <x86intrin.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define BENCH_BLOCKS    (1UL << 20)
+#define BULK_BLOCKS     256         // 4 KB buffer, stays in L1
+#define APP_SET         (32 * 1024) // stand-in for the application's L1 working set
+#define APP_LINES       8           // cache lines of it touched between two blocks
+
+typedef void (*block_fn)(uint8_t *roundkeys, uint8_t *in, uint8_t *out);
+typedef void (*bulk_fn)(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks);
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Chain the blocks so the compiler cannot drop or overlap the calls.
+ */
+static void bench_block(const char *name, block_fn fn, uint8_t *roundkeys) {
+    uint8_t block[AES_BLOCK_SIZE];
+    unsigned long n;
+    double t;
+
+    memset(block, 0, sizeof(block));
+    t = now();
+    for (n = 0; n < BENCH_BLOCKS; ++n) {
+        fn(roundkeys, block, block);
+    }
+    t = now() - t;
+    printf("%-24s %10.0f blocks/s %8.1f MB/s   (%02x)\n", name,
+           BENCH_BLOCKS / t, BENCH_BLOCKS * AES_BLOCK_SIZE / t / 1e6, block[0]);
+}
+
+/*
+ * Independent blocks, so this measures throughput rather than latency.
+ * Cycles are TSC ticks, which match core cycles only with turbo off.
+ */
+static void bench_bulk(const char *name, bulk_fn fn, uint8_t *roundkeys) {
+    static uint8_t buf[BULK_BLOCKS * AES_BLOCK_SIZE];
+    unsigned long n, iters = BENCH_BLOCKS / BULK_BLOCKS;
+    double t;
+#if AES_HAVE_AESNI
+    unsigned long long c;
+
+    c = __rdtsc();
+#endif
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        fn(roundkeys, buf, buf, BULK_BLOCKS);
+    }
+    t = now() - t;
+#if AES_HAVE_AESNI
+    c = __rdtsc() - c;
+    printf("%-24s %8.1f MB/s %6.2f cycles/byte\n", name, BENCH_BLOCKS * AES_BLOCK_SIZE / t / 1e6,
+           (double)c / (BENCH_BLOCKS * AES_BLOCK_SIZE));
+#else
+    printf("%-24s %8.1f MB/s\n", name, BENCH_BLOCKS * AES_BLOCK_SIZE / t / 1e6);
+#endif
+}
+
+/*
+ * L1D read misses of this thread, counted by the kernel. Returns -1 where perf
+ * events are unavailable (other OS, perf_event_paranoid, containers).
+ */
+static int l1d_open(void) {
+#if defined(__linux__)
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static long long l1d_misses(int fd) {
+    long long count = -1;
+#if defined(__linux__)
+    if (fd >= 0 && read(fd, &count, sizeof(count)) != sizeof(count)) {
+        count = -1;
+    }
+#endif
+    return count;
+}
+
+/*
+ * T-table layouts, alone and with APP_LINES lines of an APP_SET buffer read
+ * between blocks, which is what the application sees when AES shares L1 with it.
+ * Misses are per block and include those of the application reads.
+ */
+static void bench_layout(const char *name, block_fn fn, uint8_t *roundkeys) {
+    static uint8_t app[APP_SET];
+    uint8_t block[AES_BLOCK_SIZE];
+    unsigned long n, line = 0;
+    unsigned sink = 0, i;
+    long long misses;
+    double t;
+    int pass, fd;
+
+    memset(block, 0, sizeof(block));
+    fd = l1d_open();
+    for (pass = 0; pass < 2; ++pass) {
+#if defined(__linux__)
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+        t = now();
+        for (n = 0; n < BENCH_BLOCKS; ++n) {
+            fn(roundkeys, block, block);
+            for (i = 0; pass && i < APP_LINES; ++i) {
+                sink += app[line];
+                line = (line + 64) % APP_SET;
+            }
+        }
+        t = now() - t;
+#if defined(__linux__)
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+#endif
+        misses = l1d_misses(fd);
+        printf("%-16s%-8s %8.1f MB/s ", name, pass ? " +app" : "",
+               BENCH_BLOCKS * AES_BLOCK_SIZE / t / 1e6);
+        if (misses >= 0) {
+            printf("%8.3f L1D misses/block", (double)misses / BENCH_BLOCKS);
+        } else {
+            printf("     n/a L1D misses/block");
+        }
+        printf("   (%02x)\n", block[0] ^ (uint8_t)sink);
+    }
+#if defined(__linux__)
+    if (fd >= 0) {
+        close(fd);
+    }
+#endif
+}
+
+/*
+ * A fresh key for every block, the previous output, so that each block pays
+ * its full key setup. Compares the stored schedule with on-the-fly expansion,
+ * which for decryption has to derive the last round key first.
+ */
+static void bench_rekey(void) {
+    uint8_t key[AES_BLOCK_SIZE], block[AES_BLOCK_SIZE];
+    uint8_t roundkeys[AES_ROUND_KEY_SIZE];
+    unsigned long n, iters = BENCH_BLOCKS / 4;
+    double t;
+
+    memset(key, 0, sizeof(key));
+    memset(block, 0, sizeof(block));
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        aes_key_schedule_128(key, roundkeys);
+        aes_encrypt_128(roundkeys, block, key);
+    }
+    t = now() - t;
+    printf("%-24s %10.0f keys/s   (%02x)\n", "schedule + encrypt", iters / t, key[0]);
+
+    memset(key, 0, sizeof(key));
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        aes_encrypt_128_otf(key, block, key);
+    }
+    t = now() - t;
+    printf("%-24s %10.0f keys/s   (%02x)\n", "encrypt otf", iters / t, key[0]);
+
+    memset(key, 0, sizeof(key));
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        aes_key_schedule_128(key, roundkeys);
+        aes_decrypt_128(roundkeys, block, key);
+    }
+    t = now() - t;
+    printf("%-24s %10.0f keys/s   (%02x)\n", "schedule + decrypt", iters / t, key[0]);
+
+    memset(key, 0, sizeof(key));
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        aes_key_schedule_128_last(key, key);
+        aes_decrypt_128_otf(key, block, key);
+    }
+    t = now() - t;
+    printf("%-24s %10.0f keys/s   (%02x)\n", "last key + decrypt otf", iters / t, key[0]);
+}
+
+/*
+ * Per-key setup cost of aes_key_schedule_128_batch against one
+ * aes_key_schedule_128 call per key, for batches of a few sessions up to
+ * a thousand. The batch is rerun until about BENCH_BLOCKS keys are expanded.
+ */
+static void bench_batch_row(uint8_t *keys, uint8_t *roundkeys, uint32_t nkeys) {
+    unsigned long n, iters = BENCH_BLOCKS / 4 / nkeys;
+    uint32_t i;
+    double t, serial, batch;
+
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        for (i = 0; i < nkeys; ++i) {
+            aes_key_schedule_128(keys + AES_BLOCK_SIZE*i, roundkeys + AES_ROUND_KEY_SIZE*i);
+        }
+        keys[0] ^= roundkeys[AES_ROUND_KEY_SIZE - 1];
+    }
+    serial = (now() - t) / (iters * nkeys);
+
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        aes_key_schedule_128_batch(keys, roundkeys, nkeys);
+        keys[0] ^= roundkeys[AES_ROUND_KEY_SIZE - 1];
+    }
+    batch = (now() - t) / (iters * nkeys);
+
+    printf("batch of %-15u %7.1f ns/key serial %7.1f ns/key batch   x%.2f\n",
+           nkeys, serial * 1e9, batch * 1e9, serial / batch);
+}
+
+static void bench_batch(void) {
+    static uint8_t keys[1024 * AES_BLOCK_SIZE];
+    static uint8_t roundkeys[1024 * AES_ROUND_KEY_SIZE];
+    uint32_t i;
+
+    for (i = 0; i < sizeof(keys); ++i) {
+        keys[i] = (uint8_t)(i * 131 + 7);
+    }
+    bench_batch_row(keys, roundkeys, 8);
+    bench_batch_row(keys, roundkeys, 64);
+    bench_batch_row(keys, roundkeys, 1024);
+}
+
+/*
+ * What the key cache saves per request: a full aes_key_ctx_init (both
+ * schedules, GHASH table, CMAC subkeys) against a hit that copies the
+ * context out of a warm cache. 768 hot keys in 1024 entries, as the shards
+ * fill unevenly.
+ */
+#if AES_HAVE_PTHREAD
+static int bench_loader(uint64_t key_id, uint8_t *key, void *arg) {
+    (void)arg;
+    memset(key, (int)key_id, AES_BLOCK_SIZE);
+    return 0;
+}
+
+static void bench_keyctx(void) {
+    aes_key_cache *cache;
+    aes_key_ctx ctx;
+    uint8_t key[AES_BLOCK_SIZE];
+    uint64_t hits, misses;
+    unsigned long n, iters = BENCH_BLOCKS / 16;
+    double t;
+
+    memset(key, 0, sizeof(key));
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        key[0] = (uint8_t)n;
+        aes_key_ctx_init(&ctx, key);
+    }
+    t = now() - t;
+    printf("%-24s %7.1f ns/key   (%02x)\n", "aes_key_ctx_init", t / iters * 1e9, ctx.cmac_k2[0]);
+
+    cache = aes_key_cache_create(1024, 0, bench_loader, NULL);
+    if (cache == NULL) {
+        return;
+    }
+    for (n = 0; n < 768; ++n) {
+        aes_key_cache_get(cache, n, &ctx);
+    }
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        aes_key_cache_get(cache, n % 768, &ctx);
+    }
+    t = now() - t;
+    aes_key_cache_stats(cache, &hits, &misses);
+    printf("%-24s %7.1f ns/key   (%02x) %llu misses\n", "aes_key_cache_get hit", t / iters * 1e9, ctx.cmac_k2[0], (unsigned long long)misses);
+    aes_key_cache_destroy(cache);
+}
+#endif
+
+/*
+ * Cold start with 200k keys: expanding every schedule at startup against
+ * opening a prebuilt key store and serving the first lookup, and what the
+ * background validation of the whole store takes after that.
+ */
+#if AES_HAVE_MMAP
+#define BENCH_STORE_KEYS    200000
+
+static void bench_keystore(void) {
+    static uint64_t ids[BENCH_STORE_KEYS];
+    static uint8_t keys[BENCH_STORE_KEYS * AES_BLOCK_SIZE];
+    static uint8_t roundkeys[AES_ROUND_KEY_SIZE];
+    const char *path = "aes_bench.keystore";
+    aes_keystore *ks;
+    const uint8_t *enc = NULL;
+    uint32_t i;
+    double t;
+
+    for (i = 0; i < BENCH_STORE_KEYS; ++i) {
+        ids[i] = i;
+        memset(keys + AES_BLOCK_SIZE*i, (int)i, AES_BLOCK_SIZE);
+    }
+    t = now();
+    for (i = 0; i < BENCH_STORE_KEYS; ++i) {
+        aes_key_schedule_128(keys + AES_BLOCK_SIZE*i, roundkeys);
+        aes_key_schedule_128_dec(keys + AES_BLOCK_SIZE*i, roundkeys);
+    }
+    t = now() - t;
+    printf("%-24s %9.3f ms   (%02x)\n", "expand 200k keys", t * 1e3, roundkeys[0]);
+
+    if (aes_keystore_build(path, ids, keys, BENCH_STORE_KEYS) != 0) {
+        printf("cannot write %s\n", path);
+        return;
+    }
+    t = now();
+    ks = aes_keystore_open(path);
+    if (ks == NULL || aes_keystore_get(ks, BENCH_STORE_KEYS / 2, &enc, NULL) != AES_KEYSTORE_OK) {
+        printf("cannot read %s\n", path);
+        aes_keystore_close(ks);
+        remove(path);
+        return;
+    }
+    t = now() - t;
+    printf("%-24s %9.3f ms   (%02x)\n", "open + first lookup", t * 1e3, enc[0]);
+    t = now();
+    i = aes_keystore_validate(ks, 0, BENCH_STORE_KEYS);
+    t = now() - t;
+    printf("%-24s %9.3f ms   (%u bad)\n", "validate all", t * 1e3, i);
+    aes_keystore_close(ks);
+    remove(path);
+}
+#endif
+
+/*
+ * A context allocated and released per session: the arena (zeroized on
+ * release) against malloc with the same wipe. 64 live contexts at a time.
+ */
+#if AES_HAVE_MMAP && AES_HAVE_PTHREAD
+static void bench_arena(void) {
+    aes_key_arena *arena;
+    aes_key_ctx *live[64];
+    unsigned long n, iters = BENCH_BLOCKS / 4;
+    uint64_t locked;
+    double t;
+
+    arena = aes_key_arena_create(0, 0);
+    if (arena == NULL) {
+        return;
+    }
+    for (n = 0; n < 64; ++n) {
+        live[n] = aes_key_arena_alloc(arena);
+    }
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        aes_key_arena_free(arena, live[n & 63]);
+        live[n & 63] = aes_key_arena_alloc(arena);
+    }
+    t = now() - t;
+    aes_key_arena_stats(arena, NULL, NULL, &locked);
+    printf("%-24s %7.1f ns/ctx   %llu bytes locked\n", "arena free + alloc", t / iters * 1e9, (unsigned long long)locked);
+    aes_key_arena_destroy(arena);
+
+    for (n = 0; n < 64; ++n) {
+        live[n] = malloc(sizeof(aes_key_ctx));
+    }
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        aes_key_ctx_clear(live[n & 63]);
+        free(live[n & 63]);
+        live[n & 63] = malloc(sizeof(aes_key_ctx));
+    }
+    t = now() - t;
+    printf("%-24s %7.1f ns/ctx\n", "malloc free + alloc", t / iters * 1e9);
+    for (n = 0; n < 64; ++n) {
+        free(live[n]);
+    }
+}
+#endif
+
+/*
+ * Per-packet latency of the idle-time keystream ring: a 32-byte packet xored
+ * from a ring refilled between packets (the refill is the idle time and is
+ * left out), against aes_ctr_crypt on the same packet and against a ring that
+ * has run dry. Each packet is timed on its own; with AES-NI in TSC ticks, as
+ * in bench_bulk, which include the ~20 ticks of reading the counter.
+ */
+#define RING_PACKET     32
+
+static void bench_ring_row(const char *name, aes_ctr_ring *ring, aes_ctr_ctx *ctr, int refill) {
+    uint8_t packet[RING_PACKET];
+    unsigned long n, iters = BENCH_BLOCKS / 16;
+    double sum = 0;
+#if AES_HAVE_AESNI
+    unsigned long long t;
+#else
+    double t;
+#endif
+
+    memset(packet, 0x5a, sizeof(packet));
+    for (n = 0; n < iters; ++n) {
+        if (ring != NULL && refill) {
+            while (aes_ctr_ring_refill(ring, 8) != 0) {
+            }
+        }
+#if AES_HAVE_AESNI
+        t = __rdtsc();
+#else
+        t = now();
+#endif
+        if (ring != NULL) {
+            aes_ctr_ring_crypt(ring, packet, packet, RING_PACKET);
+        } else {
+            aes_ctr_crypt(ctr, packet, packet, RING_PACKET);
+        }
+#if AES_HAVE_AESNI
+        sum += (double)(__rdtsc() - t);
+#else
+        sum += now() - t;
+#endif
+    }
+#if AES_HAVE_AESNI
+    printf("%-24s %8.1f cycles/packet   (%02x)\n", name, sum / iters, packet[0]);
+#else
+    printf("%-24s %8.1f ns/packet   (%02x)\n", name, sum / iters * 1e9, packet[0]);
+#endif
+}
+
+static void bench_ring(void) {
+    static uint8_t buf[8 * AES_BLOCK_SIZE];
+    uint8_t key[16], iv[16];
+    aes_key_ctx ctx;
+    aes_ctr_ctx ctr;
+    aes_ctr_ring ring;
+    uint8_t i;
+
+    for (i = 0; i < 16; ++i) {
+        key[i] = (uint8_t)(i * 3 + 7);
+        iv[i] = (uint8_t)(i * 5);
+    }
+    aes_key_ctx_init(&ctx, key);
+    aes_ctr_init(&ctr, &ctx, iv, AES_CTR_32);
+    bench_ring_row("aes_ctr_crypt 32B", NULL, &ctr, 0);
+    aes_ctr_ring_init(&ring, ctx.enc, iv, AES_CTR_32, buf, 8);
+    bench_ring_row("ring crypt 32B, filled", &ring, NULL, 1);
+    bench_ring_row("ring crypt 32B, dry", &ring, NULL, 0);
+    aes_ctr_ring_reset(&ring, iv);
+}
+
+/*
+ * Cost of AES_SBOX_COMPUTED: one SubBytes/InvSubBytes of the state by table
+ * lookups and by the circuit in aes_gf.c, scaled to the AES_ROUNDS of them in
+ * a block, against the 512 bytes of SBOX and INV_SBOX it leaves out of ROM.
+ * The tables are built here from the circuit, so this runs in either build.
+ * Cycles are TSC ticks, as in bench_bulk.
+ */
+static uint8_t sbox_table[256];
+static uint8_t inv_sbox_table[256];
+
+static void sub_table(uint8_t *s) {
+    uint8_t i;
+
+    for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+        s[i] = sbox_table[s[i]];
+    }
+}
+
+static void inv_sub_table(uint8_t *s) {
+    uint8_t i;
+
+    for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+        s[i] = inv_sbox_table[s[i]];
+    }
+}
+
+static void sub_computed(uint8_t *s) {
+    aes_gf_sub_bytes(s, AES_BLOCK_SIZE);
+}
+
+static void inv_sub_computed(uint8_t *s) {
+    aes_gf_inv_sub_bytes(s, AES_BLOCK_SIZE);
+}
+
+static double bench_sub(void (*fn)(uint8_t *), uint8_t *state, double *cycles) {
+    unsigned long n, iters = BENCH_BLOCKS / 16;
+    double t;
+#if AES_HAVE_AESNI
+    unsigned long long c;
+
+    c = __rdtsc();
+#endif
+    t = now();
+    for (n = 0; n < iters; ++n) {
+        fn(state);
+    }
+    t = now() - t;
+#if AES_HAVE_AESNI
+    c = __rdtsc() - c;
+    *cycles = (double)c / iters * AES_ROUNDS;
+#else
+    *cycles = -1;
+#endif
+    return t / iters * AES_ROUNDS * 1e9;
+}
+
+static void bench_sbox_row(const char *name, void (*table)(uint8_t *), void (*computed)(uint8_t *)) {
+    uint8_t state[AES_BLOCK_SIZE];
+    double ns_table, ns_computed, cyc_table, cyc_computed;
+
+    memset(state, 0, sizeof(state));
+    ns_table = bench_sub(table, state, &cyc_table);
+    ns_computed = bench_sub(computed, state, &cyc_computed);
+    printf("%-16s table %7.1f ns/block, computed %7.1f ns/block", name, ns_table, ns_computed);
+    if (cyc_table >= 0) {
+        printf(", +%.0f cycles/block", cyc_computed - cyc_table);
+    }
+    printf("   (%02x)\n", state[0]);
+}
+
+static void bench_sbox(void) {
+    int i;
+
+    for (i = 0; i < 256; ++i) {
+        sbox_table[i] = (uint8_t)i;
+        inv_sbox_table[i] = (uint8_t)i;
+    }
+    aes_gf_sub_bytes(sbox_table, 128);
+    aes_gf_sub_bytes(sbox_table + 128, 128);
+    aes_gf_inv_sub_bytes(inv_sbox_table, 128);
+    aes_gf_inv_sub_bytes(inv_sbox_table + 128, 128);
+
+    printf("S-box: %s, computing saves %u bytes of ROM\n",
+           AES_SBOX_COMPUTED ? "computed (AES_SBOX_COMPUTED)" : "tables",
+           (unsigned)(sizeof(sbox_table) + sizeof(inv_sbox_table)));
+    bench_sbox_row("SubBytes x10", sub_table, sub_computed);
+    bench_sbox_row("InvSubBytes x10", inv_sub_table, inv_sub_computed);
+}
+
+static void loop_encrypt_128(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+    for (; nblocks > 0; --nblocks, in += AES_BLOCK_SIZE, out += AES_BLOCK_SIZE) {
+        aes_encrypt_128(roundkeys, (uint8_t *)in, out);
+    }
+}
+
+/*
+ * aes_ecb and aes_ctr take a key context. It is built from the round keys
+ * handed in, whose first 16 bytes are the key, and only rebuilt when they
+ * change, so the timed calls do not include the key setup.
+ */
+static aes_key_ctx bulk_ctx;
+
+static const aes_key_ctx *bulk_ctx_for(const uint8_t *roundkeys) {
+    if (memcmp(bulk_ctx.enc, roundkeys, AES_ROUND_KEY_SIZE) != 0) {
+        aes_key_ctx_init(&bulk_ctx, roundkeys);
+    }
+    return &bulk_ctx;
+}
+
+static void ecb_encrypt(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+    aes_ecb_encrypt_blocks(bulk_ctx_for(roundkeys), in, out, nblocks);
+}
+
+static void ecb_decrypt(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+    aes_ecb_decrypt_blocks(bulk_ctx_for(roundkeys), in, out, nblocks);
+}
+
+// CTR over the same buffer from offset 0, 32-bit counter
+static void ctr_crypt(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+    static const uint8_t iv[AES_BLOCK_SIZE] = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+                                               0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+    aes_ctr_ctx ctr;
+
+    aes_ctr_init(&ctr, bulk_ctx_for(roundkeys), iv, AES_CTR_32);
+    aes_ctr_crypt(&ctr, in, out, (size_t)nblocks * AES_BLOCK_SIZE);
+}
+
+int main(void) {
+
+    const uint8_t key[16] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+    };
+    const uint8_t key_256[32] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+        0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+        0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+        0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+    };
+    uint8_t roundkeys[AES_ROUND_KEY_SIZE];
+    uint8_t deckeys[AES_ROUND_KEY_SIZE];
+    uint8_t roundkeys_192[AES_192_ROUND_KEY_SIZE];
+    uint8_t roundkeys_256[AES_256_ROUND_KEY_SIZE];
+
+    aes_key_schedule_128(key, roundkeys);
+    aes_key_schedule_128_dec(key, deckeys);
+    aes_key_schedule_192(key_256, roundkeys_192);
+    aes_key_schedule_256(key_256, roundkeys_256);
+
+#if AES_ENGINE == AES_ENGINE_AUTO
+    printf("autotuned: encrypt %s, decrypt %s\n\n", aes_engine_selected(AES_ENGINE_ENCRYPT),
+           aes_engine_selected(AES_ENGINE_DECRYPT));
+#endif
+    bench_block("encrypt byte",   aes_encrypt_128_byte,   roundkeys);
+    bench_block("encrypt ttable", aes_encrypt_128_ttable, roundkeys);
+    bench_block("encrypt word",   aes_encrypt_128_word,   roundkeys);
+    bench_block("decrypt byte",   aes_decrypt_128_byte,   roundkeys);
+    bench_block("decrypt word",   aes_decrypt_128_word,   roundkeys);
+    bench_block("decrypt ttable", aes_decrypt_128_ttable, deckeys);
+#if AES_HAVE_AESNI
+    if (aes_cpu_has_aesni()) {
+        bench_block("encrypt aesni",  aes_encrypt_128_aesni,  roundkeys);
+        bench_block("decrypt aesni",  aes_decrypt_128_aesni,  roundkeys);
+    }
+#endif
+#if AES_HAVE_SSSE3
+    if (aes_cpu_has_ssse3()) {
+        bench_block("encrypt vperm",  aes_encrypt_128_vperm,  roundkeys);
+        bench_block("decrypt vperm",  aes_decrypt_128_vperm,  roundkeys);
+    }
+#endif
+    bench_block("aes_encrypt_128", aes_encrypt_128,       roundkeys);
+    bench_block("aes_decrypt_128", aes_decrypt_128,       roundkeys);
+    bench_block("aes_encrypt_192", aes_encrypt_192,       roundkeys_192);
+    bench_block("aes_decrypt_192", aes_decrypt_192,       roundkeys_192);
+    bench_block("aes_encrypt_256", aes_encrypt_256,       roundkeys_256);
+    bench_block("aes_decrypt_256", aes_decrypt_256,       roundkeys_256);
+
+    printf("\n");
+    bench_bulk("aes_encrypt_128 loop", loop_encrypt_128, roundkeys);
+#if AES_HAVE_SSE2
+    bench_bulk("encrypt bitslice x8", aes_encrypt_128_bs_blocks, roundkeys);
+    bench_bulk("decrypt bitslice x8", aes_decrypt_128_bs_blocks, roundkeys);
+#endif
+#if AES_HAVE_AESNI
+    if (aes_cpu_has_aesni()) {
+        bench_bulk("encrypt aesni x4/x8", aes_encrypt_128_aesni_blocks, roundkeys);
+        bench_bulk("decrypt aesni x4/x8", aes_decrypt_128_aesni_blocks, roundkeys);
+    }
+#endif
+    bench_bulk("aes_ecb_encrypt_blocks", ecb_encrypt, roundkeys);
+    bench_bulk("aes_ecb_decrypt_blocks", ecb_decrypt, roundkeys);
+    bench_bulk("aes_ctr_crypt", ctr_crypt, roundkeys);
+
+    printf("\n");
+    bench_layout("encrypt tt 4k", aes_encrypt_128_ttable_4k, roundkeys);
+    bench_layout("encrypt tt 2k", aes_encrypt_128_ttable_2k, roundkeys);
+    bench_layout("encrypt tt 1k", aes_encrypt_128_ttable_1k, roundkeys);
+    bench_layout("decrypt tt 4k", aes_decrypt_128_ttable_4k, deckeys);
+    bench_layout("decrypt tt 2k", aes_decrypt_128_ttable_2k, deckeys);
+    bench_layout("decrypt tt 1k", aes_decrypt_128_ttable_1k, deckeys);
+
+    printf("\n");
+    bench_rekey();
+
+    printf("\n");
+    bench_batch();
+
+#if AES_HAVE_PTHREAD
+    printf("\n");
+    bench_keyctx();
+#endif
+#if AES_HAVE_MMAP && AES_HAVE_PTHREAD
+    printf("\n");
+    bench_arena();
+#endif
+#if AES_HAVE_MMAP
+    printf("\n");
+    bench_keystore();
+#endif
+
+    printf("\n");
+    bench_ring();
+
+    printf("\n");
+    bench_sbox();
+
+    return 0;
+}
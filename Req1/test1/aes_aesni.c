@@ -0,0 +1,356 @@
+/*
+ * aes_aesni.c
+ *
+ * AES-NI engine. The functions are compiled for the aes/sse2 targets with
+ * function attributes, so the rest of the project keeps its default flags
+ * and the engine is picked at run time through aes_cpu_has_aesni().
+ *
+ */
+#include <stdint.h>
+#include "aes_config.h"
+#include "aes_encrypt.h"
+#include "aes_aesni.h"
+
+#if AES_HAVE_AESNI
+#include <cpuid.h>
+#include <wmmintrin.h>
+#include <tmmintrin.h>
+
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+
+/*
+ * Any thread's first call may come in at the same time as another's. They
+ * all compute the same answer, so a relaxed atomic is enough to keep the
+ * cached value free of data races.
+ */
+int aes_cpu_has_aesni(void) {
+
+    static int has_aesni = -1;
+    unsigned int eax, ebx, ecx, edx;
+    int has = __atomic_load_n(&has_aesni, __ATOMIC_RELAXED);
+
+    if (has < 0) {
+        has = __get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+              (ecx & bit_AES) && (edx & bit_SSE2);
+        __atomic_store_n(&has_aesni, has, __ATOMIC_RELAXED);
+    }
+    return has;
+}
+
+/*
+ * One step of the schedule: the previous round key and the output of
+ * aeskeygenassist (SubWord/RotWord/Rcon of its last word, in dword 3).
+ */
+static inline AESNI_TARGET __m128i key_expand(__m128i key, __m128i keygened) {
+    keygened = _mm_shuffle_epi32(keygened, _MM_SHUFFLE(3, 3, 3, 3));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, keygened);
+}
+
+// the round constant has to be an immediate
+#define KEY_EXPAND(k, rcon) key_expand((k), _mm_aeskeygenassist_si128((k), (rcon)))
+
+AESNI_TARGET void aes_key_schedule_128_aesni(const uint8_t *key, uint8_t *roundkeys) {
+
+    __m128i *rk = (__m128i *)roundkeys;
+    __m128i k;
+
+    k = _mm_loadu_si128((const __m128i *)key);
+    _mm_storeu_si128(rk,      k);
+    k = KEY_EXPAND(k, 0x01); _mm_storeu_si128(rk + 1,  k);
+    k = KEY_EXPAND(k, 0x02); _mm_storeu_si128(rk + 2,  k);
+    k = KEY_EXPAND(k, 0x04); _mm_storeu_si128(rk + 3,  k);
+    k = KEY_EXPAND(k, 0x08); _mm_storeu_si128(rk + 4,  k);
+    k = KEY_EXPAND(k, 0x10); _mm_storeu_si128(rk + 5,  k);
+    k = KEY_EXPAND(k, 0x20); _mm_storeu_si128(rk + 6,  k);
+    k = KEY_EXPAND(k, 0x40); _mm_storeu_si128(rk + 7,  k);
+    k = KEY_EXPAND(k, 0x80); _mm_storeu_si128(rk + 8,  k);
+    k = KEY_EXPAND(k, 0x1b); _mm_storeu_si128(rk + 9,  k);
+    k = KEY_EXPAND(k, 0x36); _mm_storeu_si128(rk + 10, k);
+}
+
+static AES_FORCE_INLINE AESNI_TARGET void encrypt_aesni(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext, const uint8_t rounds) {
+
+    const __m128i *rk = (const __m128i *)roundkeys;
+    __m128i s;
+    uint8_t j;
+
+    s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)plaintext), _mm_loadu_si128(rk));
+    for (j = 1; j < rounds; ++j) {
+        s = _mm_aesenc_si128(s, _mm_loadu_si128(rk + j));
+    }
+    s = _mm_aesenclast_si128(s, _mm_loadu_si128(rk + rounds));
+    _mm_storeu_si128((__m128i *)ciphertext, s);
+}
+
+static AES_FORCE_INLINE AESNI_TARGET void decrypt_aesni(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext, const uint8_t rounds) {
+
+    const __m128i *rk = (const __m128i *)roundkeys;
+    __m128i s;
+    uint8_t j;
+
+    s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)ciphertext), _mm_loadu_si128(rk + rounds));
+    for (j = rounds - 1; j > 0; --j) {
+        // aesimc does not depend on the state, so it overlaps with the previous aesdec
+        s = _mm_aesdec_si128(s, _mm_aesimc_si128(_mm_loadu_si128(rk + j)));
+    }
+    s = _mm_aesdeclast_si128(s, _mm_loadu_si128(rk));
+    _mm_storeu_si128((__m128i *)plaintext, s);
+}
+
+AESNI_TARGET void aes_encrypt_128_aesni(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext) {
+    encrypt_aesni(roundkeys, plaintext, ciphertext, AES_ROUNDS);
+}
+
+AESNI_TARGET void aes_encrypt_192_aesni(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext) {
+    encrypt_aesni(roundkeys, plaintext, ciphertext, AES_192_ROUNDS);
+}
+
+AESNI_TARGET void aes_encrypt_256_aesni(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext) {
+    encrypt_aesni(roundkeys, plaintext, ciphertext, AES_256_ROUNDS);
+}
+
+AESNI_TARGET void aes_decrypt_128_aesni(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_aesni(roundkeys, ciphertext, plaintext, AES_ROUNDS);
+}
+
+AESNI_TARGET void aes_decrypt_192_aesni(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_aesni(roundkeys, ciphertext, plaintext, AES_192_ROUNDS);
+}
+
+AESNI_TARGET void aes_decrypt_256_aesni(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_aesni(roundkeys, ciphertext, plaintext, AES_256_ROUNDS);
+}
+
+/*
+ * The block loops below are written out so that every round issues all
+ * aesenc/aesdec of the group back to back.
+ */
+#define LOAD4(b, p)     { b##0 = _mm_loadu_si128((const __m128i *)(p));      b##1 = _mm_loadu_si128((const __m128i *)(p) + 1); \
+                          b##2 = _mm_loadu_si128((const __m128i *)(p) + 2);  b##3 = _mm_loadu_si128((const __m128i *)(p) + 3); }
+#define STORE4(p, b)    { _mm_storeu_si128((__m128i *)(p), b##0);      _mm_storeu_si128((__m128i *)(p) + 1, b##1); \
+                          _mm_storeu_si128((__m128i *)(p) + 2, b##2);  _mm_storeu_si128((__m128i *)(p) + 3, b##3); }
+#define ROUND4(op, b, k) { b##0 = op(b##0, k); b##1 = op(b##1, k); b##2 = op(b##2, k); b##3 = op(b##3, k); }
+
+AESNI_TARGET void aes_encrypt_128_aesni_x4(uint8_t *roundkeys, const uint8_t *in, uint8_t *out) {
+
+    const __m128i *rk = (const __m128i *)roundkeys;
+    __m128i a0, a1, a2, a3, k;
+    uint8_t j;
+
+    LOAD4(a, in);
+    k = _mm_loadu_si128(rk);
+    ROUND4(_mm_xor_si128, a, k);
+    for (j = 1; j < AES_ROUNDS; ++j) {
+        k = _mm_loadu_si128(rk + j);
+        ROUND4(_mm_aesenc_si128, a, k);
+    }
+    k = _mm_loadu_si128(rk + AES_ROUNDS);
+    ROUND4(_mm_aesenclast_si128, a, k);
+    STORE4(out, a);
+}
+
+AESNI_TARGET void aes_encrypt_128_aesni_x8(uint8_t *roundkeys, const uint8_t *in, uint8_t *out) {
+
+    const __m128i *rk = (const __m128i *)roundkeys;
+    __m128i a0, a1, a2, a3, b0, b1, b2, b3, k;
+    uint8_t j;
+
+    LOAD4(a, in);
+    LOAD4(b, in + 64);
+    k = _mm_loadu_si128(rk);
+    ROUND4(_mm_xor_si128, a, k);
+    ROUND4(_mm_xor_si128, b, k);
+    for (j = 1; j < AES_ROUNDS; ++j) {
+        k = _mm_loadu_si128(rk + j);
+        ROUND4(_mm_aesenc_si128, a, k);
+        ROUND4(_mm_aesenc_si128, b, k);
+    }
+    k = _mm_loadu_si128(rk + AES_ROUNDS);
+    ROUND4(_mm_aesenclast_si128, a, k);
+    ROUND4(_mm_aesenclast_si128, b, k);
+    STORE4(out, a);
+    STORE4(out + 64, b);
+}
+
+AESNI_TARGET void aes_decrypt_128_aesni_x4(uint8_t *roundkeys, const uint8_t *in, uint8_t *out) {
+
+    const __m128i *rk = (const __m128i *)roundkeys;
+    __m128i a0, a1, a2, a3, k;
+    uint8_t j;
+
+    LOAD4(a, in);
+    k = _mm_loadu_si128(rk + AES_ROUNDS);
+    ROUND4(_mm_xor_si128, a, k);
+    for (j = AES_ROUNDS - 1; j > 0; --j) {
+        k = _mm_aesimc_si128(_mm_loadu_si128(rk + j));
+        ROUND4(_mm_aesdec_si128, a, k);
+    }
+    k = _mm_loadu_si128(rk);
+    ROUND4(_mm_aesdeclast_si128, a, k);
+    STORE4(out, a);
+}
+
+AESNI_TARGET void aes_decrypt_128_aesni_x8(uint8_t *roundkeys, const uint8_t *in, uint8_t *out) {
+
+    const __m128i *rk = (const __m128i *)roundkeys;
+    __m128i a0, a1, a2, a3, b0, b1, b2, b3, k;
+    uint8_t j;
+
+    LOAD4(a, in);
+    LOAD4(b, in + 64);
+    k = _mm_loadu_si128(rk + AES_ROUNDS);
+    ROUND4(_mm_xor_si128, a, k);
+    ROUND4(_mm_xor_si128, b, k);
+    for (j = AES_ROUNDS - 1; j > 0; --j) {
+        k = _mm_aesimc_si128(_mm_loadu_si128(rk + j));
+        ROUND4(_mm_aesdec_si128, a, k);
+        ROUND4(_mm_aesdec_si128, b, k);
+    }
+    k = _mm_loadu_si128(rk);
+    ROUND4(_mm_aesdeclast_si128, a, k);
+    ROUND4(_mm_aesdeclast_si128, b, k);
+    STORE4(out, a);
+    STORE4(out + 64, b);
+}
+
+void aes_encrypt_128_aesni_blocks(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+
+    for (; nblocks >= 8; nblocks -= 8, in += 128, out += 128) {
+        aes_encrypt_128_aesni_x8(roundkeys, in, out);
+    }
+    if (nblocks >= 4) {
+        aes_encrypt_128_aesni_x4(roundkeys, in, out);
+        nblocks -= 4;
+        in += 64;
+        out += 64;
+    }
+    for (; nblocks > 0; --nblocks, in += 16, out += 16) {
+        aes_encrypt_128_aesni(roundkeys, (uint8_t *)in, out);
+    }
+}
+
+void aes_decrypt_128_aesni_blocks(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+
+    for (; nblocks >= 8; nblocks -= 8, in += 128, out += 128) {
+        aes_decrypt_128_aesni_x8(roundkeys, in, out);
+    }
+    if (nblocks >= 4) {
+        aes_decrypt_128_aesni_x4(roundkeys, in, out);
+        nblocks -= 4;
+        in += 64;
+        out += 64;
+    }
+    for (; nblocks > 0; --nblocks, in += 16, out += 16) {
+        aes_decrypt_128_aesni(roundkeys, (uint8_t *)in, out);
+    }
+}
+
+/*
+ * Batched key schedule. aeskeygenassist is microcoded on many cores and takes
+ * its round constant as an immediate, so the batch gets SubWord from aesenclast
+ * instead: with the last word broadcast to all four columns ShiftRows does
+ * nothing, and RotWord commutes with SubWord, so it is applied before. Every
+ * round expands four keys back to back, which keeps the AES unit busy while
+ * each key waits for its previous round.
+ */
+static const uint8_t RCON[10] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
+
+static inline AESNI_TARGET __m128i key_assist(__m128i key, __m128i rcon) {
+    __m128i t = _mm_shuffle_epi32(key, _MM_SHUFFLE(3, 3, 3, 3));
+    t = _mm_or_si128(_mm_srli_epi32(t, 8), _mm_slli_epi32(t, 24));
+    return _mm_aesenclast_si128(t, rcon);
+}
+
+#define KEY_STEP4(b, rcon) { b##0 = key_expand(b##0, key_assist(b##0, rcon)); b##1 = key_expand(b##1, key_assist(b##1, rcon)); \
+                             b##2 = key_expand(b##2, key_assist(b##2, rcon)); b##3 = key_expand(b##3, key_assist(b##3, rcon)); }
+#define STORE4_RK(rk, j, b) { _mm_storeu_si128((rk) + (j), b##0);       _mm_storeu_si128((rk) + 11 + (j), b##1); \
+                              _mm_storeu_si128((rk) + 22 + (j), b##2);  _mm_storeu_si128((rk) + 33 + (j), b##3); }
+
+AESNI_TARGET void aes_key_schedule_128_aesni_x4(const uint8_t *keys, uint8_t *roundkeys) {
+
+    __m128i *rk = (__m128i *)roundkeys;
+    __m128i a0, a1, a2, a3, rcon;
+    uint8_t j;
+
+    LOAD4(a, keys);
+    STORE4_RK(rk, 0, a);
+    for (j = 1; j <= AES_ROUNDS; ++j) {
+        rcon = _mm_set1_epi32(RCON[j-1]);
+        KEY_STEP4(a, rcon);
+        STORE4_RK(rk, j, a);
+    }
+}
+
+void aes_key_schedule_128_aesni_batch(const uint8_t *keys, uint8_t *roundkeys, uint32_t nkeys) {
+    for (; nkeys >= 4; nkeys -= 4) {
+        aes_key_schedule_128_aesni_x4(keys, roundkeys);
+        keys += 4*AES_BLOCK_SIZE;
+        roundkeys += 4*AES_ROUND_KEY_SIZE;
+    }
+    for (; nkeys > 0; --nkeys) {
+        aes_key_schedule_128_aesni(keys, roundkeys);
+        keys += AES_BLOCK_SIZE;
+        roundkeys += AES_ROUND_KEY_SIZE;
+    }
+}
+
+/*
+ * CTR keystream xored into the data. The counter is kept byte-reversed in a
+ * register, so the next counters are one paddd on its low 32 bits each and a
+ * pshufb back to big endian. pshufb is SSSE3, which every CPU with AES-NI
+ * has, but the caller checks it as well.
+ */
+#define AESNI_SSSE3_TARGET __attribute__((target("aes,sse2,ssse3")))
+
+#define CTR4(b, c, bswap) { b##0 = _mm_shuffle_epi8((c), bswap);                                       \
+                            b##1 = _mm_shuffle_epi8(_mm_add_epi32((c), _mm_set_epi32(0, 0, 0, 1)), bswap); \
+                            b##2 = _mm_shuffle_epi8(_mm_add_epi32((c), _mm_set_epi32(0, 0, 0, 2)), bswap); \
+                            b##3 = _mm_shuffle_epi8(_mm_add_epi32((c), _mm_set_epi32(0, 0, 0, 3)), bswap); }
+#define XOR4(b, p)      { b##0 = _mm_xor_si128(b##0, _mm_loadu_si128((const __m128i *)(p)));      \
+                          b##1 = _mm_xor_si128(b##1, _mm_loadu_si128((const __m128i *)(p) + 1));  \
+                          b##2 = _mm_xor_si128(b##2, _mm_loadu_si128((const __m128i *)(p) + 2));  \
+                          b##3 = _mm_xor_si128(b##3, _mm_loadu_si128((const __m128i *)(p) + 3)); }
+
+AESNI_SSSE3_TARGET void aes_ctr_128_aesni_blocks(uint8_t *roundkeys, const uint8_t *counter, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+
+    const __m128i *rk = (const __m128i *)roundkeys;
+    const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i a0, a1, a2, a3, b0, b1, b2, b3, c, k;
+    uint8_t j;
+
+    c = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)counter), bswap);
+    for (; nblocks >= 8; nblocks -= 8, in += 128, out += 128) {
+        CTR4(a, c, bswap);
+        CTR4(b, _mm_add_epi32(c, _mm_set_epi32(0, 0, 0, 4)), bswap);
+        c = _mm_add_epi32(c, _mm_set_epi32(0, 0, 0, 8));
+        k = _mm_loadu_si128(rk);
+        ROUND4(_mm_xor_si128, a, k);
+        ROUND4(_mm_xor_si128, b, k);
+        for (j = 1; j < AES_ROUNDS; ++j) {
+            k = _mm_loadu_si128(rk + j);
+            ROUND4(_mm_aesenc_si128, a, k);
+            ROUND4(_mm_aesenc_si128, b, k);
+        }
+        k = _mm_loadu_si128(rk + AES_ROUNDS);
+        ROUND4(_mm_aesenclast_si128, a, k);
+        ROUND4(_mm_aesenclast_si128, b, k);
+        XOR4(a, in);
+        XOR4(b, in + 64);
+        STORE4(out, a);
+        STORE4(out + 64, b);
+    }
+    for (; nblocks > 0; --nblocks, in += 16, out += 16) {
+        a0 = _mm_xor_si128(_mm_shuffle_epi8(c, bswap), _mm_loadu_si128(rk));
+        c = _mm_add_epi32(c, _mm_set_epi32(0, 0, 0, 1));
+        for (j = 1; j < AES_ROUNDS; ++j) {
+            a0 = _mm_aesenc_si128(a0, _mm_loadu_si128(rk + j));
+        }
+        a0 = _mm_aesenclast_si128(a0, _mm_loadu_si128(rk + AES_ROUNDS));
+        _mm_storeu_si128((__m128i *)out, _mm_xor_si128(a0, _mm_loadu_si128((const __m128i *)in)));
+    }
+}
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * aes_aesni.h
+ *
+ * AES-NI engine for x86 hosts. Only built when aes_config.h sets
+ * AES_HAVE_AESNI, and only safe to call when aes_cpu_has_aesni() says so.
+ * Round keys use the same 176-byte layout as aes_key_schedule_128 (208 and
+ * 240 bytes for AES-192/256), so the schedules of all engines are interchangeable.
+ *
+ */
+#ifndef AES_AESNI_H
+#define AES_AESNI_H
+#include <stdint.h>
+#include "aes_config.h"
+
+#if AES_HAVE_AESNI
+
+/**
+ * @purpose:            CPUID check for the AES and SSE2 instructions. The answer is cached.
+ * @return:             1 if the AES-NI engine can run on this CPU, 0 otherwise
+ */
+int aes_cpu_has_aesni(void);
+
+/**
+ * @purpose:            Key schedule for AES-128 with aeskeygenassist
+ * @par[in]key:         16 bytes of master keys
+ * @par[out]roundkeys:  176 bytes of round keys
+ */
+void aes_key_schedule_128_aesni(const uint8_t *key, uint8_t *roundkeys);
+
+/**
+ * @purpose:            Encryption with aesenc/aesenclast. Same contract as aes_encrypt_128.
+ */
+void aes_encrypt_128_aesni(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+
+/**
+ * @purpose:            Decryption with aesdec/aesdeclast. Takes the encryption round keys
+ *                      like aes_decrypt_128 and converts the middle ones with aesimc on the fly.
+ */
+void aes_decrypt_128_aesni(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+
+/**
+ * @purpose:            The same kernels for AES-192 and AES-256, round keys from
+ *                      aes_key_schedule_192/aes_key_schedule_256.
+ */
+void aes_encrypt_192_aesni(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+void aes_encrypt_256_aesni(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+void aes_decrypt_192_aesni(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+void aes_decrypt_256_aesni(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+
+/*
+ * Interleaved kernels for the multi-block modes (ECB, CTR, CBC decryption, XTS).
+ * A single block leaves the AES unit idle while each round waits for the previous
+ * one; running 4 or 8 independent blocks through each round hides that latency.
+ * The blocks are contiguous, in and out may point to the same memory, and all of
+ * them take the encryption round keys from aes_key_schedule_128.
+ */
+void aes_encrypt_128_aesni_x4(uint8_t *roundkeys, const uint8_t *in, uint8_t *out);
+void aes_encrypt_128_aesni_x8(uint8_t *roundkeys, const uint8_t *in, uint8_t *out);
+void aes_decrypt_128_aesni_x4(uint8_t *roundkeys, const uint8_t *in, uint8_t *out);
+void aes_decrypt_128_aesni_x8(uint8_t *roundkeys, const uint8_t *in, uint8_t *out);
+
+/**
+ * @purpose:            Any number of contiguous blocks, 8 at a time, then 4, then one by one.
+ * @par[in]roundkeys:   round keys from aes_key_schedule_128
+ * @par[in]in:          nblocks * 16 bytes of input
+ * @par[out]out:        nblocks * 16 bytes of output, may be the same as in
+ */
+void aes_encrypt_128_aesni_blocks(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks);
+void aes_decrypt_128_aesni_blocks(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks);
+
+/**
+ * @purpose:            Key schedules for many keys at once, four keys per pass with aesenclast
+ *                      standing in for aeskeygenassist. Same result as aes_key_schedule_128_aesni
+ *                      on each key.
+ * @par[in]keys:        nkeys * 16 bytes of master keys
+ * @par[out]roundkeys:  nkeys * 176 bytes, the schedule of key i at roundkeys + 176*i
+ */
+void aes_key_schedule_128_aesni_x4(const uint8_t *keys, uint8_t *roundkeys);
+void aes_key_schedule_128_aesni_batch(const uint8_t *keys, uint8_t *roundkeys, uint32_t nkeys);
+
+/**
+ * @purpose:            CTR keystream for nblocks blocks, xored into in. Needs SSSE3 besides
+ *                      AES-NI (aes_cpu_has_ssse3). Only the low 32 bits of the counter are
+ *                      incremented and they must not wrap within nblocks, aes_ctr.c splits
+ *                      the runs where they would.
+ * @par[in]counter:     16-byte big-endian counter block of the first block
+ * @par[in]in:          nblocks * 16 bytes of input
+ * @par[out]out:        nblocks * 16 bytes of output, may be the same as in
+ */
+void aes_ctr_128_aesni_blocks(uint8_t *roundkeys, const uint8_t *counter, const uint8_t *in, uint8_t *out, uint32_t nblocks);
+
+#endif
+#endif
@@ -0,0 +1,443 @@
+/*
+ * aes_bitslice.c
+ *
+ * Constant-time bitsliced engine on 128-bit SSE2 registers, 8 blocks per call.
+ *
+ * The 8 blocks are transposed into 8 bit planes: plane k holds bit k of every
+ * state byte, byte i of a plane is state byte i and bit b of that byte belongs
+ * to block b. SubBytes is evaluated as a Boolean circuit on the planes, and
+ * ShiftRows/MixColumns only move whole bytes inside a plane, so there is no
+ * memory access that depends on the data or the key.
+ *
+ */
+#include <stdint.h>
+#include <string.h>
+#include "aes_config.h"
+#include "aes_encrypt.h"
+#include "aes_bitslice.h"
+
+#if AES_HAVE_SSE2
+#include <emmintrin.h>
+
+#define XOR(a, b)   _mm_xor_si128((a), (b))
+#define AND(a, b)   _mm_and_si128((a), (b))
+#define NOT(a)      _mm_xor_si128((a), _mm_set1_epi32(-1))
+#define ROTR32(a, n) _mm_or_si128(_mm_srli_epi32((a), (n)), _mm_slli_epi32((a), 32 - (n)))
+
+/*
+ * Exchange the bits selected by m in a with the bits n positions higher in b.
+ */
+#define SWAPMOVE(a, b, n, m) { \
+    t = AND(XOR(_mm_srli_epi64((b), (n)), (a)), (m)); \
+    (a) = XOR((a), t); \
+    (b) = XOR((b), _mm_slli_epi64(t, (n))); }
+
+/**
+ * @purpose:    Transpose the 8x8 bit matrix in every byte lane of q[0..7].
+ *              Turns 8 blocks into 8 bit planes and, being its own inverse, back.
+ */
+static void bs_transpose(__m128i *q) {
+    const __m128i m1 = _mm_set1_epi8(0x55);
+    const __m128i m2 = _mm_set1_epi8(0x33);
+    const __m128i m4 = _mm_set1_epi8(0x0f);
+    __m128i t;
+
+    SWAPMOVE(q[1], q[0], 1, m1);
+    SWAPMOVE(q[3], q[2], 1, m1);
+    SWAPMOVE(q[5], q[4], 1, m1);
+    SWAPMOVE(q[7], q[6], 1, m1);
+    SWAPMOVE(q[2], q[0], 2, m2);
+    SWAPMOVE(q[3], q[1], 2, m2);
+    SWAPMOVE(q[6], q[4], 2, m2);
+    SWAPMOVE(q[7], q[5], 2, m2);
+    SWAPMOVE(q[4], q[0], 4, m4);
+    SWAPMOVE(q[5], q[1], 4, m4);
+    SWAPMOVE(q[6], q[2], 4, m4);
+    SWAPMOVE(q[7], q[3], 4, m4);
+}
+
+/**
+ * @purpose:    SubBytes on the bit planes, Boyar-Peralta circuit (113 gates + 4 NOT).
+ *              x0 is the most significant bit.
+ */
+static void bs_sbox(__m128i *q) {
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7;
+    __m128i y1, y2, y3, y4, y5, y6, y7, y8, y9, y10, y11, y12, y13, y14, y15;
+    __m128i y16, y17, y18, y19, y20, y21;
+    __m128i z0, z1, z2, z3, z4, z5, z6, z7, z8, z9, z10, z11, z12, z13, z14, z15, z16, z17;
+    __m128i t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15;
+    __m128i t16, t17, t18, t19, t20, t21, t22, t23, t24, t25, t26, t27, t28, t29, t30, t31;
+    __m128i t32, t33, t34, t35, t36, t37, t38, t39, t40, t41, t42, t43, t44, t45, t46, t47;
+    __m128i t48, t49, t50, t51, t52, t53, t54, t55, t56, t57, t58, t59, t60, t61, t62, t63;
+    __m128i t64, t65, t66, t67;
+    __m128i s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    y14 = XOR(x3, x5);
+    y13 = XOR(x0, x6);
+    y9 = XOR(x0, x3);
+    y8 = XOR(x0, x5);
+    t0 = XOR(x1, x2);
+    y1 = XOR(t0, x7);
+    y4 = XOR(y1, x3);
+    y12 = XOR(y13, y14);
+    y2 = XOR(y1, x0);
+    y5 = XOR(y1, x6);
+    y3 = XOR(y5, y8);
+    t1 = XOR(x4, y12);
+    y15 = XOR(t1, x5);
+    y20 = XOR(t1, x1);
+    y6 = XOR(y15, x7);
+    y10 = XOR(y15, t0);
+    y11 = XOR(y20, y9);
+    y7 = XOR(x7, y11);
+    y17 = XOR(y10, y11);
+    y19 = XOR(y10, y8);
+    y16 = XOR(t0, y11);
+    y21 = XOR(y13, y16);
+    y18 = XOR(x0, y16);
+    t2 = AND(y12, y15);
+    t3 = AND(y3, y6);
+    t4 = XOR(t3, t2);
+    t5 = AND(y4, x7);
+    t6 = XOR(t5, t2);
+    t7 = AND(y13, y16);
+    t8 = AND(y5, y1);
+    t9 = XOR(t8, t7);
+    t10 = AND(y2, y7);
+    t11 = XOR(t10, t7);
+    t12 = AND(y9, y11);
+    t13 = AND(y14, y17);
+    t14 = XOR(t13, t12);
+    t15 = AND(y8, y10);
+    t16 = XOR(t15, t12);
+    t17 = XOR(t4, t14);
+    t18 = XOR(t6, t16);
+    t19 = XOR(t9, t14);
+    t20 = XOR(t11, t16);
+    t21 = XOR(t17, y20);
+    t22 = XOR(t18, y19);
+    t23 = XOR(t19, y21);
+    t24 = XOR(t20, y18);
+    t25 = XOR(t21, t22);
+    t26 = AND(t21, t23);
+    t27 = XOR(t24, t26);
+    t28 = AND(t25, t27);
+    t29 = XOR(t28, t22);
+    t30 = XOR(t23, t24);
+    t31 = XOR(t22, t26);
+    t32 = AND(t31, t30);
+    t33 = XOR(t32, t24);
+    t34 = XOR(t23, t33);
+    t35 = XOR(t27, t33);
+    t36 = AND(t24, t35);
+    t37 = XOR(t36, t34);
+    t38 = XOR(t27, t36);
+    t39 = AND(t29, t38);
+    t40 = XOR(t25, t39);
+    t41 = XOR(t40, t37);
+    t42 = XOR(t29, t33);
+    t43 = XOR(t29, t40);
+    t44 = XOR(t33, t37);
+    t45 = XOR(t42, t41);
+    z0 = AND(t44, y15);
+    z1 = AND(t37, y6);
+    z2 = AND(t33, x7);
+    z3 = AND(t43, y16);
+    z4 = AND(t40, y1);
+    z5 = AND(t29, y7);
+    z6 = AND(t42, y11);
+    z7 = AND(t45, y17);
+    z8 = AND(t41, y10);
+    z9 = AND(t44, y12);
+    z10 = AND(t37, y3);
+    z11 = AND(t33, y4);
+    z12 = AND(t43, y13);
+    z13 = AND(t40, y5);
+    z14 = AND(t29, y2);
+    z15 = AND(t42, y9);
+    z16 = AND(t45, y14);
+    z17 = AND(t41, y8);
+    t46 = XOR(z15, z16);
+    t47 = XOR(z10, z11);
+    t48 = XOR(z5, z13);
+    t49 = XOR(z9, z10);
+    t50 = XOR(z2, z12);
+    t51 = XOR(z2, z5);
+    t52 = XOR(z7, z8);
+    t53 = XOR(z0, z3);
+    t54 = XOR(z6, z7);
+    t55 = XOR(z16, z17);
+    t56 = XOR(z12, t48);
+    t57 = XOR(t50, t53);
+    t58 = XOR(z4, t46);
+    t59 = XOR(z3, t54);
+    t60 = XOR(t46, t57);
+    t61 = XOR(z14, t57);
+    t62 = XOR(t52, t58);
+    t63 = XOR(t49, t58);
+    t64 = XOR(z4, t59);
+    t65 = XOR(t61, t62);
+    t66 = XOR(z1, t63);
+    s0 = XOR(t59, t63);
+    s6 = XOR(t56, NOT(t62));
+    s7 = XOR(t48, NOT(t60));
+    t67 = XOR(t64, t65);
+    s3 = XOR(t53, t66);
+    s4 = XOR(t51, t66);
+    s5 = XOR(t47, t65);
+    s1 = XOR(t64, NOT(s3));
+    s2 = XOR(t55, NOT(t67));
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+/**
+ * @purpose:    Inverse of the linear part of the affine transform, y <<< 1 ^ y <<< 3 ^ y <<< 6
+ */
+static void bs_affine_inv(__m128i *q) {
+    __m128i y[8];
+    uint8_t k;
+
+    for (k = 0; k < 8; ++k) {
+        y[k] = q[k];
+    }
+    for (k = 0; k < 8; ++k) {
+        q[k] = XOR(XOR(y[(k + 7) & 7], y[(k + 5) & 7]), y[(k + 2) & 7]);
+    }
+}
+
+/**
+ * @purpose:    InvSubBytes from the forward circuit:
+ *              S^-1(y) = L^-1(S(L^-1(y ^ 63)) ^ 63), L being the linear part of the affine transform.
+ *              ^ 63 flips planes 0, 1, 5 and 6.
+ */
+static void bs_inv_sbox(__m128i *q) {
+    q[0] = NOT(q[0]);
+    q[1] = NOT(q[1]);
+    q[5] = NOT(q[5]);
+    q[6] = NOT(q[6]);
+    bs_affine_inv(q);
+    bs_sbox(q);
+    q[0] = NOT(q[0]);
+    q[1] = NOT(q[1]);
+    q[5] = NOT(q[5]);
+    q[6] = NOT(q[6]);
+    bs_affine_inv(q);
+}
+
+/**
+ * @purpose:    ShiftRows inside every plane. A 32-bit lane is a column and byte r of
+ *              the lane is row r, so row r takes its byte from the lane r columns to the right.
+ */
+static void bs_shift_rows(__m128i *q) {
+    const __m128i m1 = _mm_set1_epi32(0x0000ff00);
+    const __m128i m2 = _mm_set1_epi32(0x00ff0000);
+    const __m128i m3 = _mm_set1_epi32((int)0xff000000);
+    const __m128i m0 = _mm_set1_epi32(0x000000ff);
+    uint8_t k;
+
+    for (k = 0; k < 8; ++k) {
+        q[k] = XOR(XOR(AND(q[k], m0), AND(_mm_shuffle_epi32(q[k], _MM_SHUFFLE(0, 3, 2, 1)), m1)),
+                   XOR(AND(_mm_shuffle_epi32(q[k], _MM_SHUFFLE(1, 0, 3, 2)), m2),
+                       AND(_mm_shuffle_epi32(q[k], _MM_SHUFFLE(2, 1, 0, 3)), m3)));
+    }
+}
+
+static void bs_inv_shift_rows(__m128i *q) {
+    const __m128i m1 = _mm_set1_epi32(0x0000ff00);
+    const __m128i m2 = _mm_set1_epi32(0x00ff0000);
+    const __m128i m3 = _mm_set1_epi32((int)0xff000000);
+    const __m128i m0 = _mm_set1_epi32(0x000000ff);
+    uint8_t k;
+
+    for (k = 0; k < 8; ++k) {
+        q[k] = XOR(XOR(AND(q[k], m0), AND(_mm_shuffle_epi32(q[k], _MM_SHUFFLE(2, 1, 0, 3)), m1)),
+                   XOR(AND(_mm_shuffle_epi32(q[k], _MM_SHUFFLE(1, 0, 3, 2)), m2),
+                       AND(_mm_shuffle_epi32(q[k], _MM_SHUFFLE(0, 3, 2, 1)), m3)));
+    }
+}
+
+/**
+ * @purpose:    MixColumns, out = 02.t ^ rot1(a) ^ rot2(t) with t = a ^ rot1(a), rotN moving
+ *              row r+N to row r inside each column. Multiplying the planes by 02 only
+ *              renames planes and folds plane 7 into planes 1, 3 and 4.
+ */
+static void bs_mix_columns(__m128i *q) {
+    __m128i r[8], t[8];
+    uint8_t k;
+
+    for (k = 0; k < 8; ++k) {
+        r[k] = ROTR32(q[k], 8);
+        t[k] = XOR(q[k], r[k]);
+        q[k] = XOR(r[k], ROTR32(t[k], 16));
+    }
+    q[0] = XOR(q[0], t[7]);
+    q[1] = XOR(q[1], XOR(t[0], t[7]));
+    q[2] = XOR(q[2], t[1]);
+    q[3] = XOR(q[3], XOR(t[2], t[7]));
+    q[4] = XOR(q[4], XOR(t[3], t[7]));
+    q[5] = XOR(q[5], t[4]);
+    q[6] = XOR(q[6], t[5]);
+    q[7] = XOR(q[7], t[6]);
+}
+
+/**
+ * @purpose:    InvMixColumns = MixColumns after a ^= 04.(a ^ rot2(a)), see aes_decrypt.c
+ */
+static void bs_inv_mix_columns(__m128i *q) {
+    __m128i w[8];
+    uint8_t k;
+
+    for (k = 0; k < 8; ++k) {
+        w[k] = XOR(q[k], ROTR32(q[k], 16));
+    }
+    // multiply by 04
+    q[0] = XOR(q[0], w[6]);
+    q[1] = XOR(q[1], XOR(w[7], w[6]));
+    q[2] = XOR(q[2], XOR(w[0], w[7]));
+    q[3] = XOR(q[3], XOR(w[1], w[6]));
+    q[4] = XOR(q[4], XOR(XOR(w[2], w[7]), w[6]));
+    q[5] = XOR(q[5], XOR(w[3], w[7]));
+    q[6] = XOR(q[6], w[4]);
+    q[7] = XOR(q[7], w[5]);
+    bs_mix_columns(q);
+}
+
+static void bs_add_round_key(__m128i *q, const uint8_t *bskeys) {
+    uint8_t k;
+
+    for (k = 0; k < 8; ++k) {
+        q[k] = XOR(q[k], _mm_loadu_si128((const __m128i *)bskeys + k));
+    }
+}
+
+void aes_bs_key_schedule_128(const uint8_t *roundkeys, uint8_t *bskeys) {
+
+    uint8_t r, k, i;
+
+    // plane k, byte i of a round key is all ones when bit k of round key byte i is set
+    for (r = 0; r <= AES_ROUNDS; ++r) {
+        for (k = 0; k < 8; ++k) {
+            for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+                *bskeys++ = (uint8_t)(0 - ((roundkeys[i] >> k) & 1));
+            }
+        }
+        roundkeys += AES_BLOCK_SIZE;
+    }
+}
+
+void aes_encrypt_128_bs8(const uint8_t *bskeys, const uint8_t *in, uint8_t *out) {
+
+    __m128i q[8];
+    uint8_t j, k;
+
+    for (k = 0; k < 8; ++k) {
+        q[k] = _mm_loadu_si128((const __m128i *)in + k);
+    }
+    bs_transpose(q);
+
+    bs_add_round_key(q, bskeys);
+    for (j = 1; j < AES_ROUNDS; ++j) {
+        bs_sbox(q);
+        bs_shift_rows(q);
+        bs_mix_columns(q);
+        bs_add_round_key(q, bskeys + j * AES_BS_PLANES_SIZE);
+    }
+    bs_sbox(q);
+    bs_shift_rows(q);
+    bs_add_round_key(q, bskeys + AES_ROUNDS * AES_BS_PLANES_SIZE);
+
+    bs_transpose(q);
+    for (k = 0; k < 8; ++k) {
+        _mm_storeu_si128((__m128i *)out + k, q[k]);
+    }
+}
+
+void aes_decrypt_128_bs8(const uint8_t *bskeys, const uint8_t *in, uint8_t *out) {
+
+    __m128i q[8];
+    uint8_t j, k;
+
+    for (k = 0; k < 8; ++k) {
+        q[k] = _mm_loadu_si128((const __m128i *)in + k);
+    }
+    bs_transpose(q);
+
+    bs_add_round_key(q, bskeys + AES_ROUNDS * AES_BS_PLANES_SIZE);
+    for (j = AES_ROUNDS - 1; j > 0; --j) {
+        bs_inv_shift_rows(q);
+        bs_inv_sbox(q);
+        bs_add_round_key(q, bskeys + j * AES_BS_PLANES_SIZE);
+        bs_inv_mix_columns(q);
+    }
+    bs_inv_shift_rows(q);
+    bs_inv_sbox(q);
+    bs_add_round_key(q, bskeys);
+
+    bs_transpose(q);
+    for (k = 0; k < 8; ++k) {
+        _mm_storeu_si128((__m128i *)out + k, q[k]);
+    }
+}
+
+/*
+ * Full groups of 8 go straight through, a short last group is padded in a
+ * local buffer.
+ */
+static void bs_blocks(void (*bs8)(const uint8_t *, const uint8_t *, uint8_t *),
+                      const uint8_t *bskeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+
+    uint8_t tail[8 * AES_BLOCK_SIZE];
+
+    for (; nblocks >= 8; nblocks -= 8, in += 8 * AES_BLOCK_SIZE, out += 8 * AES_BLOCK_SIZE) {
+        bs8(bskeys, in, out);
+    }
+    if (nblocks > 0) {
+        memset(tail, 0, sizeof(tail));
+        memcpy(tail, in, nblocks * AES_BLOCK_SIZE);
+        bs8(bskeys, tail, tail);
+        memcpy(out, tail, nblocks * AES_BLOCK_SIZE);
+    }
+}
+
+void aes_encrypt_128_bs_blocks(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+
+    uint8_t bskeys[AES_BS_ROUND_KEY_SIZE];
+
+    aes_bs_key_schedule_128(roundkeys, bskeys);
+    bs_blocks(aes_encrypt_128_bs8, bskeys, in, out, nblocks);
+}
+
+void aes_decrypt_128_bs_blocks(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+
+    uint8_t bskeys[AES_BS_ROUND_KEY_SIZE];
+
+    aes_bs_key_schedule_128(roundkeys, bskeys);
+    bs_blocks(aes_decrypt_128_bs8, bskeys, in, out, nblocks);
+}
+
+void aes_encrypt_128_bs8_blocks(const uint8_t *bskeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+    bs_blocks(aes_encrypt_128_bs8, bskeys, in, out, nblocks);
+}
+
+void aes_decrypt_128_bs8_blocks(const uint8_t *bskeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+    bs_blocks(aes_decrypt_128_bs8, bskeys, in, out, nblocks);
+}
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * aes_bitslice.h
+ *
+ * Constant-time bitsliced engine, 8 blocks per call on SSE2. Meant for hosts
+ * where AES-NI is not available, and as a batch kernel for the multi-block modes.
+ *
+ */
+#ifndef AES_BITSLICE_H
+#define AES_BITSLICE_H
+#include <stdint.h>
+#include "aes_config.h"
+
+#if AES_HAVE_SSE2
+
+#define AES_BS_PLANES_SIZE      128     // 8 bit planes of 16 bytes, one round key
+#define AES_BS_ROUND_KEY_SIZE   1408    // (10+1)x128
+
+/**
+ * @purpose:            Spread the round keys from aes_key_schedule_128 over bit planes.
+ * @par[in]roundkeys:   176 bytes of round keys
+ * @par[out]bskeys:     1408 bytes of bitsliced round keys
+ */
+void aes_bs_key_schedule_128(const uint8_t *roundkeys, uint8_t *bskeys);
+
+/**
+ * @purpose:            Encrypt / decrypt 8 contiguous blocks (128 bytes) at once.
+ *                      The input and output may point to the same memory
+ * @par[in]bskeys:      bitsliced round keys from aes_bs_key_schedule_128
+ */
+void aes_encrypt_128_bs8(const uint8_t *bskeys, const uint8_t *in, uint8_t *out);
+void aes_decrypt_128_bs8(const uint8_t *bskeys, const uint8_t *in, uint8_t *out);
+
+/**
+ * @purpose:            Batch entry points for the multi-block modes, any number of blocks.
+ *                      The round keys are converted once per call.
+ * @par[in]roundkeys:   round keys from aes_key_schedule_128
+ * @par[in]in:          nblocks * 16 bytes of input
+ * @par[out]out:        nblocks * 16 bytes of output, may be the same as in
+ */
+void aes_encrypt_128_bs_blocks(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks);
+void aes_decrypt_128_bs_blocks(uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks);
+
+/**
+ * @purpose:            Same, on round keys already converted by aes_bs_key_schedule_128, e.g.
+ *                      the ones a key context keeps.
+ * @par[in]bskeys:      1408 bytes of bitsliced round keys
+ */
+void aes_encrypt_128_bs8_blocks(const uint8_t *bskeys, const uint8_t *in, uint8_t *out, uint32_t nblocks);
+void aes_decrypt_128_bs8_blocks(const uint8_t *bskeys, const uint8_t *in, uint8_t *out, uint32_t nblocks);
+
+#endif
+#endif
@@ -0,0 +1,106 @@
+/*
+ * aes_config.h
+ *
+ * Build-time selection of the engine behind aes_encrypt_128, aes_decrypt_128
+ * and aes_key_schedule_128, and their 192- and 256-bit counterparts.
+ * Override with -DAES_ENGINE=... in the project symbols.
+ *
+ */
+#ifndef AES_CONFIG_H
+#define AES_CONFIG_H
+
+#define AES_ENGINE_BYTE     0   // byte-wise round loop, 256-byte SBOX only (aes_encrypt.c)
+#define AES_ENGINE_TTABLE   1   // 32-bit T-table engine, 4 KB of tables (aes_ttable.c)
+#define AES_ENGINE_AUTO     2   // fastest engine this CPU runs, timed on first use (aes_engine.c)
+#define AES_ENGINE_WORD     3   // 32-bit column words with SWAR MixColumns, 256-byte SBOX only (aes_encrypt.c)
+
+/*
+ * AES-NI and the SSSE3 vector-permute engine need x86 and a compiler that
+ * understands target attributes
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AES_HAVE_AESNI      1
+#define AES_HAVE_SSSE3      1
+#else
+#define AES_HAVE_AESNI      0
+#define AES_HAVE_SSSE3      0
+#endif
+
+/*
+ * The bitsliced engine only needs SSE2, which every x86-64 CPU has
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__SSE2__))
+#define AES_HAVE_SSE2       1
+#else
+#define AES_HAVE_SSE2       0
+#endif
+
+#ifndef AES_ENGINE
+#if defined(__AVR__)
+#define AES_ENGINE          AES_ENGINE_BYTE
+#elif AES_HAVE_AESNI
+#define AES_ENGINE          AES_ENGINE_AUTO
+#else
+#define AES_ENGINE          AES_ENGINE_TTABLE
+#endif
+#endif
+
+/*
+ * Table layout of the T-table engine, per direction. Smaller layouts leave
+ * more of L1 to the application at the cost of rotates or wider entries.
+ * The _4k, _2k and _1k entry points in aes_ttable.h are always available,
+ * this picks the one behind aes_encrypt_*_ttable and aes_decrypt_128_ttable.
+ */
+#define AES_TTABLE_4K       0   // Te0..Te3, 4 x 1 KB, no rotates
+#define AES_TTABLE_1K       1   // Te0 only, three rotates per column
+#define AES_TTABLE_2K       2   // Te0 doubled to 8-byte entries, rotations by unaligned loads
+
+#ifndef AES_TTABLE_LAYOUT
+#define AES_TTABLE_LAYOUT   AES_TTABLE_4K
+#endif
+
+/*
+ * Table-free S-box for the smallest flash budgets. With 1, SBOX and INV_SBOX
+ * (512 bytes) are not compiled: the byte and word engines and the key schedule
+ * evaluate SubBytes and InvSubBytes with the bitsliced circuit in aes_gf.c, and
+ * the T-table engine takes its last round from Te0/Td0. aes_bench reports what
+ * this costs per block.
+ */
+#ifndef AES_SBOX_COMPUTED
+#define AES_SBOX_COMPUTED   0
+#endif
+
+/*
+ * One kernel body serves AES-128, -192 and -256. It is force-inlined into a
+ * wrapper per key size, so its round count is a constant there and the
+ * compiler can unroll and schedule each size as if it were written out.
+ */
+#if defined(__GNUC__)
+#define AES_FORCE_INLINE    inline __attribute__((always_inline))
+#else
+#define AES_FORCE_INLINE    inline
+#endif
+
+/*
+ * Alignment for round keys and tables that vector engines load whole
+ */
+#if defined(__GNUC__)
+#define AES_ALIGN(n)        __attribute__((aligned(n)))
+#else
+#define AES_ALIGN(n)
+#endif
+
+/*
+ * The key cache (aes_keycache.c) needs malloc and POSIX threads, the key store
+ * (aes_keystore.c) files and mmap. Like the autotuner they are built empty
+ * where those are missing, e.g. for the AVR project.
+ */
+#if !defined(__AVR__) && (defined(__unix__) || defined(__APPLE__))
+#define AES_HAVE_PTHREAD    1
+#define AES_HAVE_MMAP       1
+#else
+#define AES_HAVE_PTHREAD    0
+#define AES_HAVE_MMAP       0
+#endif
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * aes_ctr.c
+ *
+ * CTR mode, see aes_ctr.h. Whole blocks are produced in runs over which only
+ * the low 32 bits of the counter change, which is what the kernels increment;
+ * a run ends where those bits wrap and the next one starts from a counter
+ * recomputed with the full carry.
+ *
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include "aes_config.h"
+#include "aes_key.h"
+#include "aes_ctr.h"
+#include "aes_ecb.h"
+#include "aes_encrypt.h"
+#include "aes_aesni.h"
+#include "aes_vperm.h"
+
+#define CTR_BATCH       8       // counter blocks per aes_ecb_encrypt_blocks call
+
+static uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void store_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+int aes_ctr_init(aes_ctr_ctx *ctr, const aes_key_ctx *key, const uint8_t *iv, uint8_t width) {
+
+    uint8_t i;
+
+    if (width != AES_CTR_32 && width != AES_CTR_64 && width != AES_CTR_128) {
+        return -1;
+    }
+    ctr->key = key;
+    for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+        ctr->iv[i] = iv[i];
+    }
+    ctr->width = width;
+    ctr->offset = 0;
+    return 0;
+}
+
+void aes_ctr_counter(const aes_ctr_ctx *ctr, uint64_t block, uint8_t *counter) {
+
+    uint16_t carry = 0;
+    uint8_t i;
+
+    for (i = 0; i < AES_BLOCK_SIZE - ctr->width / 8; ++i) {
+        counter[i] = ctr->iv[i];
+    }
+    // big-endian addition over the counter bytes, the carry out of the top one is dropped
+    for (i = AES_BLOCK_SIZE; i > AES_BLOCK_SIZE - ctr->width / 8; --i) {
+        carry += ctr->iv[i-1] + (uint8_t)block;
+        counter[i-1] = (uint8_t)carry;
+        carry >>= 8;
+        block >>= 8;
+    }
+}
+
+void aes_ctr_seek(aes_ctr_ctx *ctr, uint64_t offset) {
+
+    uint8_t counter[AES_BLOCK_SIZE];
+
+    ctr->offset = offset;
+    if (offset % AES_BLOCK_SIZE != 0) {
+        aes_ctr_counter(ctr, offset / AES_BLOCK_SIZE, counter);
+        aes_encrypt_128((uint8_t *)ctr->key->enc, counter, ctr->keystream);
+    }
+}
+
+/*
+ * Counter blocks of a run in batches, encrypted by the ECB bulk path and
+ * xored into the data
+ */
+static void ctr_run_ecb(const aes_key_ctx *key, const uint8_t *counter, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+
+    uint8_t ks[CTR_BATCH * AES_BLOCK_SIZE];
+    uint32_t low = load_be32(counter + 12);
+    uint32_t m, i;
+    uint8_t j;
+
+    while (nblocks > 0) {
+        m = nblocks < CTR_BATCH ? nblocks : CTR_BATCH;
+        for (i = 0; i < m; ++i) {
+            for (j = 0; j < 12; ++j) {
+                ks[AES_BLOCK_SIZE*i + j] = counter[j];
+            }
+            store_be32(ks + AES_BLOCK_SIZE*i + 12, low + i);
+        }
+        aes_ecb_encrypt_blocks(key, ks, ks, m);
+        for (i = 0; i < m * AES_BLOCK_SIZE; ++i) {
+            out[i] = in[i] ^ ks[i];
+        }
+        low += m;
+        in += m * AES_BLOCK_SIZE;
+        out += m * AES_BLOCK_SIZE;
+        nblocks -= m;
+    }
+}
+
+static void ctr_run(const aes_key_ctx *key, const uint8_t *counter, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+#if AES_ENGINE == AES_ENGINE_AUTO && AES_HAVE_AESNI && AES_HAVE_SSSE3
+    if (aes_cpu_has_aesni() && aes_cpu_has_ssse3()) {
+        aes_ctr_128_aesni_blocks((uint8_t *)key->enc, counter, in, out, nblocks);
+        return;
+    }
+#endif
+    ctr_run_ecb(key, counter, in, out, nblocks);
+}
+
+void aes_ctr_crypt(aes_ctr_ctx *ctr, const uint8_t *in, uint8_t *out, size_t len) {
+
+    uint8_t counter[AES_BLOCK_SIZE];
+    uint8_t pos = (uint8_t)(ctr->offset % AES_BLOCK_SIZE);
+    uint64_t nblocks, room;
+    uint32_t run;
+
+    // the rest of a block started by an earlier call
+    for (; pos != 0 && pos < AES_BLOCK_SIZE && len > 0; ++pos, --len) {
+        *out++ = *in++ ^ ctr->keystream[pos];
+        ++ctr->offset;
+    }
+
+    for (nblocks = len / AES_BLOCK_SIZE; nblocks > 0; nblocks -= run) {
+        aes_ctr_counter(ctr, ctr->offset / AES_BLOCK_SIZE, counter);
+        // blocks until the low 32 bits wrap, capped so that a run fits its type
+        room = 0x100000000ULL - load_be32(counter + 12);
+        if (room > 0xffffffffU) {
+            room = 0xffffffffU;
+        }
+        run = (uint32_t)(nblocks < room ? nblocks : room);
+        ctr_run(ctr->key, counter, in, out, run);
+        in += (size_t)run * AES_BLOCK_SIZE;
+        out += (size_t)run * AES_BLOCK_SIZE;
+        ctr->offset += (uint64_t)run * AES_BLOCK_SIZE;
+    }
+    len %= AES_BLOCK_SIZE;
+
+    // a partial last block keeps its keystream for the next call
+    if (len > 0) {
+        aes_ctr_counter(ctr, ctr->offset / AES_BLOCK_SIZE, counter);
+        aes_encrypt_128((uint8_t *)ctr->key->enc, counter, ctr->keystream);
+        for (pos = 0; pos < len; ++pos) {
+            out[pos] = in[pos] ^ ctr->keystream[pos];
+        }
+        ctr->offset += len;
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ * aes_ctr.h
+ *
+ * CTR mode (NIST SP 800-38A) on a key context. Block i of the stream is
+ * encrypted under the counter block iv + i, where the addition only runs over
+ * the low 32, 64 or 128 bits of the block (big endian) and wraps there; the
+ * bits above are the nonce. Any byte offset can be reached by aes_ctr_seek
+ * without generating the keystream before it, so large objects can be
+ * decrypted in parallel pieces or at random.
+ *
+ */
+#ifndef AES_CTR_H
+#define AES_CTR_H
+#include <stddef.h>
+#include <stdint.h>
+#include "aes_config.h"
+#include "aes_key.h"
+#include "aes_schedule.h"
+
+#define AES_CTR_32      32      // GCM and most protocols: 96-bit nonce, 32-bit block counter
+#define AES_CTR_64      64      // 64-bit nonce, 64-bit block counter
+#define AES_CTR_128     128     // the whole block is the counter
+
+typedef struct aes_ctr_ctx {
+    const aes_key_ctx *key;
+    uint8_t iv[AES_BLOCK_SIZE];         // counter block of stream offset 0
+    uint8_t keystream[AES_BLOCK_SIZE];  // keystream of the block holding offset, valid when offset is not on a block boundary
+    uint64_t offset;                    // stream position in bytes
+    uint8_t width;                      // AES_CTR_32, AES_CTR_64 or AES_CTR_128
+} aes_ctr_ctx;
+
+/**
+ * @purpose:            Start a stream at offset 0. The key context is referenced, not copied.
+ * @par[in]key:         expanded key from aes_key_ctx_init
+ * @par[in]iv:          16-byte initial counter block
+ * @par[in]width:       counter width, AES_CTR_32, AES_CTR_64 or AES_CTR_128
+ * @return:             0, or -1 if width is none of those
+ */
+int aes_ctr_init(aes_ctr_ctx *ctr, const aes_key_ctx *key, const uint8_t *iv, uint8_t width);
+
+/**
+ * @purpose:            Move to a byte offset of the stream in constant time. Costs at most one
+ *                      block encryption, when offset is not on a block boundary.
+ */
+void aes_ctr_seek(aes_ctr_ctx *ctr, uint64_t offset);
+
+/**
+ * @purpose:            Encrypt or decrypt len bytes at the current offset and advance it.
+ *                      Whole blocks go through the widest engine, 8 at a time.
+ * @par[in]in:          len bytes
+ * @par[out]out:        len bytes, may be the same as in
+ */
+void aes_ctr_crypt(aes_ctr_ctx *ctr, const uint8_t *in, uint8_t *out, size_t len);
+
+/**
+ * @purpose:            Counter block of block index block of the stream (byte offset 16*block).
+ * @par[out]counter:    16 bytes
+ */
+void aes_ctr_counter(const aes_ctr_ctx *ctr, uint64_t block, uint8_t *counter);
+#endif
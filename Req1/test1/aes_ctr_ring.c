@@ -0,0 +1,167 @@
+/*
+ * aes_ctr_ring.c
+ *
+ * Idle-time CTR keystream ring, see aes_ctr_ring.h. Single producer (refill)
+ * and single consumer (crypt): each side owns its index and only the fill
+ * count is shared. Refill publishes a block by adding 16 to fill after
+ * writing it, crypt releases bytes by subtracting after reading them, so
+ * neither ever touches bytes the other side may still be working on.
+ *
+ */
+#include <stdint.h>
+#include <string.h>
+#include "aes_config.h"
+#include "aes_ctr_ring.h"
+#include "aes_ctr.h"
+#include "aes_encrypt.h"
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+// fill is 16 bits: two loads / stores on the AVR, so every access masks interrupts there
+static uint16_t fill_load(aes_ctr_ring *ring) {
+#if defined(__AVR__)
+    uint16_t fill;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        fill = ring->fill;
+    }
+    return fill;
+#elif defined(__GNUC__)
+    return __atomic_load_n(&ring->fill, __ATOMIC_ACQUIRE);
+#else
+    return ring->fill;
+#endif
+}
+
+static void fill_add(aes_ctr_ring *ring, uint16_t n) {
+#if defined(__AVR__)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ring->fill += n;
+    }
+#elif defined(__GNUC__)
+    __atomic_fetch_add(&ring->fill, n, __ATOMIC_RELEASE);
+#else
+    ring->fill += n;
+#endif
+}
+
+static void fill_sub(aes_ctr_ring *ring, uint16_t n) {
+#if defined(__AVR__)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ring->fill -= n;
+    }
+#elif defined(__GNUC__)
+    __atomic_fetch_sub(&ring->fill, n, __ATOMIC_RELEASE);
+#else
+    ring->fill -= n;
+#endif
+}
+
+static void counter_start(aes_ctr_ring *ring, const uint8_t *iv) {
+
+    uint8_t i;
+
+    for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+        ring->counter[i] = iv[i];
+    }
+}
+
+// +1 over the low width bits, big endian, wrapping there like aes_ctr_counter
+static void counter_next(aes_ctr_ring *ring) {
+
+    uint8_t i;
+
+    for (i = AES_BLOCK_SIZE; i > AES_BLOCK_SIZE - ring->width / 8; --i) {
+        if (++ring->counter[i-1] != 0) {
+            break;
+        }
+    }
+}
+
+int aes_ctr_ring_init(aes_ctr_ring *ring, uint8_t *roundkeys, const uint8_t *iv, uint8_t width,
+                      uint8_t *buf, uint16_t nblocks) {
+
+    if (width != AES_CTR_32 && width != AES_CTR_64 && width != AES_CTR_128) {
+        return -1;
+    }
+    // size has to fit 16 bits with room for fill to reach it
+    if (nblocks == 0 || nblocks > 0xfff) {
+        return -1;
+    }
+    ring->roundkeys = roundkeys;
+    ring->buf = buf;
+    ring->size = (uint16_t)(nblocks * AES_BLOCK_SIZE);
+    ring->width = width;
+    aes_ctr_ring_reset(ring, iv);
+    return 0;
+}
+
+void aes_ctr_ring_reset(aes_ctr_ring *ring, const uint8_t *iv) {
+    memset(ring->buf, 0, ring->size);
+    counter_start(ring, iv);
+    ring->head = 0;
+    ring->tail = 0;
+    ring->fill = 0;
+}
+
+uint8_t aes_ctr_ring_refill(aes_ctr_ring *ring, uint8_t max_blocks) {
+
+    uint8_t done;
+
+    for (done = 0; done < max_blocks; ++done) {
+        if (ring->size - fill_load(ring) < AES_BLOCK_SIZE) {
+            break;
+        }
+        aes_encrypt_128(ring->roundkeys, ring->counter, ring->buf + ring->tail);
+        counter_next(ring);
+        ring->tail += AES_BLOCK_SIZE;
+        if (ring->tail == ring->size) {
+            ring->tail = 0;
+        }
+        fill_add(ring, AES_BLOCK_SIZE);
+    }
+    return done;
+}
+
+uint16_t aes_ctr_ring_available(aes_ctr_ring *ring) {
+    return fill_load(ring);
+}
+
+uint16_t aes_ctr_ring_crypt(aes_ctr_ring *ring, const uint8_t *in, uint8_t *out, uint16_t len) {
+
+    uint16_t generated = 0;
+    uint16_t n, i;
+    const uint8_t *ks;
+
+    while (len > 0) {
+        n = fill_load(ring);
+        if (n == 0) {
+            // dry: the ring is empty, so head == tail and the next block is ours to make
+            aes_ctr_ring_refill(ring, 1);
+            n = AES_BLOCK_SIZE;
+            generated += len < n ? len : n;
+        }
+        // up to the end of the ring, the rest on the next pass
+        if (n > ring->size - ring->head) {
+            n = ring->size - ring->head;
+        }
+        if (n > len) {
+            n = len;
+        }
+        ks = ring->buf + ring->head;
+        for (i = 0; i < n; ++i) {
+            out[i] = in[i] ^ ks[i];
+        }
+        ring->head += n;
+        if (ring->head == ring->size) {
+            ring->head = 0;
+        }
+        fill_sub(ring, n);
+        in += n;
+        out += n;
+        len -= n;
+    }
+    return generated;
+}
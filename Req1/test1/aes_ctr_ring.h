@@ -0,0 +1,76 @@
+/*
+ * aes_ctr_ring.h
+ *
+ * CTR keystream generated ahead of time, for nodes with a tight packet
+ * deadline and idle time between packets. The idle loop (or a low-priority
+ * task) calls aes_ctr_ring_refill, which encrypts the next counter blocks
+ * into a ring; aes_ctr_ring_crypt then only xors the packet with keystream
+ * that is already there. Same stream as aes_ctr_crypt with the same key, iv
+ * and counter width.
+ *
+ * Sized for the AVR: the ring is the caller's memory, 16 bytes per block, and
+ * the key is the 176-byte schedule of aes_key_schedule_128 rather than a key
+ * context.
+ *
+ * aes_ctr_ring_crypt may interrupt aes_ctr_ring_refill (packet handler in an
+ * ISR or a higher-priority task, refill in the main loop): it only takes
+ * keystream refill has published. If the ring runs dry, crypt encrypts the
+ * missing blocks itself, which is only safe while refill is not running, so
+ * size the ring for the largest burst or call both from the same context.
+ *
+ */
+#ifndef AES_CTR_RING_H
+#define AES_CTR_RING_H
+#include <stdint.h>
+#include "aes_config.h"
+
+typedef struct aes_ctr_ring {
+    uint8_t *roundkeys;                 // aes_key_schedule_128 of the key
+    uint8_t *buf;                       // ring, size bytes
+    uint8_t counter[16];                // counter block of the next block to generate
+    uint16_t size;                      // multiple of 16
+    uint16_t head;                      // next keystream byte to use, owned by crypt
+    uint16_t tail;                      // where the next block goes, owned by refill
+    volatile uint16_t fill;             // keystream bytes ready, shared
+    uint8_t width;                      // counter bits, 32, 64 or 128 as in aes_ctr.h
+} aes_ctr_ring;
+
+/**
+ * @purpose:            Set up an empty ring at the start of a stream.
+ * @par[in]roundkeys:   176 bytes from aes_key_schedule_128, referenced
+ * @par[in]iv:          16-byte initial counter block
+ * @par[in]width:       AES_CTR_32, AES_CTR_64 or AES_CTR_128
+ * @par[in]buf:         nblocks * 16 bytes of ring memory
+ * @par[in]nblocks:     ring size in blocks, 1 .. 4095
+ * @return:             0, or -1 for a bad width or size
+ */
+int aes_ctr_ring_init(aes_ctr_ring *ring, uint8_t *roundkeys, const uint8_t *iv, uint8_t width,
+                      uint8_t *buf, uint16_t nblocks);
+
+/**
+ * @purpose:            Idle hook. Encrypt up to max_blocks counter blocks into the free part of
+ *                      the ring, one aes_encrypt_128 each, so the caller bounds the time spent.
+ * @return:             blocks generated, 0 once the ring is full
+ */
+uint8_t aes_ctr_ring_refill(aes_ctr_ring *ring, uint8_t max_blocks);
+
+/**
+ * @purpose:            Keystream bytes ready for aes_ctr_ring_crypt without any encryption
+ */
+uint16_t aes_ctr_ring_available(aes_ctr_ring *ring);
+
+/**
+ * @purpose:            Encrypt or decrypt len bytes as the next part of the stream. A plain xor
+ *                      while the ring holds len bytes of keystream.
+ * @par[in]in:          len bytes
+ * @par[out]out:        len bytes, may be the same as in
+ * @return:             bytes whose keystream had to be generated on the spot, 0 on the fast path
+ */
+uint16_t aes_ctr_ring_crypt(aes_ctr_ring *ring, const uint8_t *in, uint8_t *out, uint16_t len);
+
+/**
+ * @purpose:            Restart at a new initial counter block, e.g. for the next session.
+ *                      Wipes the keystream still in the ring. Not safe against a running refill.
+ */
+void aes_ctr_ring_reset(aes_ctr_ring *ring, const uint8_t *iv);
+#endif
@@ -12,10 +12,15 @@
  *
  */
 #include <stdint.h>
+#include "aes_config.h"
+#include "aes_gf.h"
 #include "aes_decrypt.h"
+#include "aes_schedule.h"
+#include "aes_engine.h"
 
 
-static uint8_t INV_SBOX[256] = {
+#if !AES_SBOX_COMPUTED
+uint8_t INV_SBOX[256] = {
     0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
     0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
     0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
@@ -32,16 +37,14 @@ static uint8_t INV_SBOX[256] = {
     0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
     0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
     0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d};
+#endif
 
 /**
- * https://en.wikipedia.org/wiki/Finite_field_arithmetic
- * Multiply two numbers in the GF(2^8) finite field defined
- * by the polynomial x^8 + x^4 + x^3 + x + 1 = 0
- * We do use mul2(int8_t a) but not mul(uint8_t a, uint8_t b)
- * just in order to get a higher speed.
+ * @purpose:    InvMixColumns on one column word: w ^= 04.(w ^ rot16(w)), then MixColumns,
+ *              the word form of gf_inv_mix_column.
  */
-static inline uint8_t mul2(uint8_t a) {
-    return (a&0x80) ? ((a<<1)^0x1b) : (a<<1);
+static inline uint32_t inv_mix_column_word(uint32_t w) {
+    return gf_mix_column_word(w ^ gf_xtime_word(gf_xtime_word(w ^ gf_rotr32(w, 16))));
 }
 /**
  * @purpose:    Inverse ShiftRows
@@ -73,25 +76,39 @@ static void inv_shift_rows(uint8_t *state) {
     *(state+11) = *(state+15);
     *(state+15) = temp;
 }
- void aes_decrypt_128( uint8_t *roundkeys,  uint8_t *ciphertext, uint8_t *plaintext) {
+/*
+ * With otf set, roundkeys is a 16-byte buffer holding the last AES-128 round
+ * key, and the schedule is run backwards in it one round at a time.
+ */
+static AES_FORCE_INLINE void decrypt_byte( uint8_t *roundkeys,  uint8_t *ciphertext, uint8_t *plaintext, const uint8_t rounds,
+                                           const uint8_t otf) {
 
     uint8_t tmp[16];
-    uint8_t t, u, v;
     uint8_t i, j;
 
-    roundkeys += 160;
+    if (!otf) {
+        roundkeys += 16*rounds;
+    }
 
     // first round
     for ( i = 0; i < AES_BLOCK_SIZE; ++i ) {
         *(plaintext+i) = *(ciphertext+i) ^ *(roundkeys+i);
     }
-    roundkeys -= 16;
+    if (otf) {
+        aes_key_schedule_128_prev(roundkeys, rounds);
+    } else {
+        roundkeys -= 16;
+    }
     inv_shift_rows(plaintext);
+#if AES_SBOX_COMPUTED
+    aes_gf_inv_sub_bytes(plaintext, AES_BLOCK_SIZE);
+#else
     for (i = 0; i < AES_BLOCK_SIZE; ++i) {
         *(plaintext+i) = INV_SBOX[*(plaintext+i)];
     }
+#endif
 
-    for (j = 1; j < AES_ROUNDS; ++j) {
+    for (j = 1; j < rounds; ++j) {
         
         // Inverse AddRoundKey
         for ( i = 0; i < AES_BLOCK_SIZE; ++i ) {
@@ -106,29 +123,26 @@ static void inv_shift_rows(uint8_t *state) {
          * [0b 0d 09 0e]   [s3  s7  s11 s15]
          */
         for (i = 0; i < AES_BLOCK_SIZE; i+=4) {
-            t = tmp[i] ^ tmp[i+1] ^ tmp[i+2] ^ tmp[i+3];
-            plaintext[i]   = t ^ tmp[i]   ^ mul2(tmp[i]   ^ tmp[i+1]);
-            plaintext[i+1] = t ^ tmp[i+1] ^ mul2(tmp[i+1] ^ tmp[i+2]);
-            plaintext[i+2] = t ^ tmp[i+2] ^ mul2(tmp[i+2] ^ tmp[i+3]);
-            plaintext[i+3] = t ^ tmp[i+3] ^ mul2(tmp[i+3] ^ tmp[i]);
-            u = mul2(mul2(tmp[i]   ^ tmp[i+2]));
-            v = mul2(mul2(tmp[i+1] ^ tmp[i+3]));
-            t = mul2(u ^ v);
-            plaintext[i]   ^= t ^ u;
-            plaintext[i+1] ^= t ^ v;
-            plaintext[i+2] ^= t ^ u;
-            plaintext[i+3] ^= t ^ v;
+            gf_inv_mix_column(plaintext + i, tmp + i);
         }
         
         // Inverse ShiftRows
         inv_shift_rows(plaintext);
         
         // Inverse SubBytes
+#if AES_SBOX_COMPUTED
+        aes_gf_inv_sub_bytes(plaintext, AES_BLOCK_SIZE);
+#else
         for (i = 0; i < AES_BLOCK_SIZE; ++i) {
             *(plaintext+i) = INV_SBOX[*(plaintext+i)];
         }
+#endif
 
-        roundkeys -= 16;
+        if (otf) {
+            aes_key_schedule_128_prev(roundkeys, rounds-j);
+        } else {
+            roundkeys -= 16;
+        }
 
     }
 
@@ -137,4 +151,176 @@ static void inv_shift_rows(uint8_t *state) {
         *(plaintext+i) ^= *(roundkeys+i);
     }
 
-}
\ No newline at end of file
+}
+
+ void aes_decrypt_128_byte( uint8_t *roundkeys,  uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_byte(roundkeys, ciphertext, plaintext, AES_ROUNDS, 0);
+}
+
+ void aes_decrypt_192_byte( uint8_t *roundkeys,  uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_byte(roundkeys, ciphertext, plaintext, AES_192_ROUNDS, 0);
+}
+
+ void aes_decrypt_256_byte( uint8_t *roundkeys,  uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_byte(roundkeys, ciphertext, plaintext, AES_256_ROUNDS, 0);
+}
+
+#if AES_SBOX_COMPUTED
+/*
+ * InvSubBytes runs on the whole state first, InvShiftRows is then a byte
+ * select: row r of output column c comes from input column c - r.
+ */
+#define INV_SUB_STATE(s0, s1, s2, s3)   inv_sub_state(&(s0), &(s1), &(s2), &(s3))
+#define INV_SUB_SHIFT_WORD(w0, w1, w2, w3) \
+    (((w0) & 0xff) ^ ((w1) & 0xff00) ^ ((w2) & 0xff0000) ^ ((w3) & 0xff000000))
+
+static void inv_sub_state(uint32_t *s0, uint32_t *s1, uint32_t *s2, uint32_t *s3) {
+
+    uint8_t b[AES_BLOCK_SIZE];
+
+    gf_store_word(b     , *s0);
+    gf_store_word(b +  4, *s1);
+    gf_store_word(b +  8, *s2);
+    gf_store_word(b + 12, *s3);
+    aes_gf_inv_sub_bytes(b, AES_BLOCK_SIZE);
+    *s0 = gf_load_word(b     );
+    *s1 = gf_load_word(b +  4);
+    *s2 = gf_load_word(b +  8);
+    *s3 = gf_load_word(b + 12);
+}
+#else
+/*
+ * InvShiftRows and InvSubBytes in one pass: row r of output column c comes
+ * from input column c - r.
+ */
+#define INV_SUB_STATE(s0, s1, s2, s3)
+#define INV_SUB_SHIFT_WORD(w0, w1, w2, w3) \
+    ((uint32_t)INV_SBOX[(w0) & 0xff] ^ ((uint32_t)INV_SBOX[((w1) >> 8) & 0xff] << 8) ^ \
+     ((uint32_t)INV_SBOX[((w2) >> 16) & 0xff] << 16) ^ ((uint32_t)INV_SBOX[(w3) >> 24] << 24))
+#endif
+
+static AES_FORCE_INLINE void decrypt_word( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext, const uint8_t rounds,
+                                           const uint8_t otf) {
+
+    uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+    uint8_t j;
+
+    if (!otf) {
+        roundkeys += 16*rounds;
+    }
+
+    // first round
+    s0 = gf_load_word(ciphertext     ) ^ gf_load_word(roundkeys     );
+    s1 = gf_load_word(ciphertext +  4) ^ gf_load_word(roundkeys +  4);
+    s2 = gf_load_word(ciphertext +  8) ^ gf_load_word(roundkeys +  8);
+    s3 = gf_load_word(ciphertext + 12) ^ gf_load_word(roundkeys + 12);
+    INV_SUB_STATE(s0, s1, s2, s3);
+    t0 = INV_SUB_SHIFT_WORD(s0, s3, s2, s1);
+    t1 = INV_SUB_SHIFT_WORD(s1, s0, s3, s2);
+    t2 = INV_SUB_SHIFT_WORD(s2, s1, s0, s3);
+    t3 = INV_SUB_SHIFT_WORD(s3, s2, s1, s0);
+
+    for (j = 1; j < rounds; ++j) {
+        if (otf) {
+            aes_key_schedule_128_prev(roundkeys, rounds-j+1);
+        } else {
+            roundkeys -= 16;
+        }
+        s0 = inv_mix_column_word(t0 ^ gf_load_word(roundkeys     ));
+        s1 = inv_mix_column_word(t1 ^ gf_load_word(roundkeys +  4));
+        s2 = inv_mix_column_word(t2 ^ gf_load_word(roundkeys +  8));
+        s3 = inv_mix_column_word(t3 ^ gf_load_word(roundkeys + 12));
+        INV_SUB_STATE(s0, s1, s2, s3);
+        t0 = INV_SUB_SHIFT_WORD(s0, s3, s2, s1);
+        t1 = INV_SUB_SHIFT_WORD(s1, s0, s3, s2);
+        t2 = INV_SUB_SHIFT_WORD(s2, s1, s0, s3);
+        t3 = INV_SUB_SHIFT_WORD(s3, s2, s1, s0);
+    }
+
+    // last AddRoundKey
+    if (otf) {
+        aes_key_schedule_128_prev(roundkeys, 1);
+    } else {
+        roundkeys -= 16;
+    }
+    t0 ^= gf_load_word(roundkeys     );
+    t1 ^= gf_load_word(roundkeys +  4);
+    t2 ^= gf_load_word(roundkeys +  8);
+    t3 ^= gf_load_word(roundkeys + 12);
+    gf_store_word(plaintext     , t0);
+    gf_store_word(plaintext +  4, t1);
+    gf_store_word(plaintext +  8, t2);
+    gf_store_word(plaintext + 12, t3);
+}
+
+void aes_decrypt_128_word( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_word(roundkeys, ciphertext, plaintext, AES_ROUNDS, 0);
+}
+
+void aes_decrypt_192_word( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_word(roundkeys, ciphertext, plaintext, AES_192_ROUNDS, 0);
+}
+
+void aes_decrypt_256_word( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_word(roundkeys, ciphertext, plaintext, AES_256_ROUNDS, 0);
+}
+
+void aes_decrypt_128_byte_otf(const uint8_t *lastkey, uint8_t *ciphertext, uint8_t *plaintext) {
+
+    uint8_t roundkey[AES_BLOCK_SIZE];
+    uint8_t i;
+
+    for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+        roundkey[i] = lastkey[i];
+    }
+    decrypt_byte(roundkey, ciphertext, plaintext, AES_ROUNDS, 1);
+}
+
+void aes_decrypt_128_word_otf(const uint8_t *lastkey, uint8_t *ciphertext, uint8_t *plaintext) {
+
+    uint8_t roundkey[AES_BLOCK_SIZE];
+    uint8_t i;
+
+    for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+        roundkey[i] = lastkey[i];
+    }
+    decrypt_word(roundkey, ciphertext, plaintext, AES_ROUNDS, 1);
+}
+
+void aes_decrypt_128_otf(const uint8_t *lastkey, uint8_t *ciphertext, uint8_t *plaintext) {
+#if AES_ENGINE == AES_ENGINE_BYTE
+    aes_decrypt_128_byte_otf(lastkey, ciphertext, plaintext);
+#else
+    aes_decrypt_128_word_otf(lastkey, ciphertext, plaintext);
+#endif
+}
+
+void aes_decrypt_128( uint8_t *roundkeys,  uint8_t *ciphertext, uint8_t *plaintext) {
+#if AES_ENGINE == AES_ENGINE_AUTO
+    AES_ENGINE_GET(aes_decrypt_engine[AES_ENGINE_128])(roundkeys, ciphertext, plaintext);
+#elif AES_ENGINE == AES_ENGINE_TTABLE || AES_ENGINE == AES_ENGINE_WORD
+    aes_decrypt_128_word(roundkeys, ciphertext, plaintext);
+#else
+    aes_decrypt_128_byte(roundkeys, ciphertext, plaintext);
+#endif
+}
+
+void aes_decrypt_192( uint8_t *roundkeys,  uint8_t *ciphertext, uint8_t *plaintext) {
+#if AES_ENGINE == AES_ENGINE_AUTO
+    AES_ENGINE_GET(aes_decrypt_engine[AES_ENGINE_192])(roundkeys, ciphertext, plaintext);
+#elif AES_ENGINE == AES_ENGINE_TTABLE || AES_ENGINE == AES_ENGINE_WORD
+    aes_decrypt_192_word(roundkeys, ciphertext, plaintext);
+#else
+    aes_decrypt_192_byte(roundkeys, ciphertext, plaintext);
+#endif
+}
+
+void aes_decrypt_256( uint8_t *roundkeys,  uint8_t *ciphertext, uint8_t *plaintext) {
+#if AES_ENGINE == AES_ENGINE_AUTO
+    AES_ENGINE_GET(aes_decrypt_engine[AES_ENGINE_256])(roundkeys, ciphertext, plaintext);
+#elif AES_ENGINE == AES_ENGINE_TTABLE || AES_ENGINE == AES_ENGINE_WORD
+    aes_decrypt_256_word(roundkeys, ciphertext, plaintext);
+#else
+    aes_decrypt_256_byte(roundkeys, ciphertext, plaintext);
+#endif
+}
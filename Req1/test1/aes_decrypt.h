@@ -14,9 +14,15 @@
 #define AES_128_DECRYPT_H
 #include <stdint.h>
 
+extern uint8_t INV_SBOX[256];
+
 #define AES_BLOCK_SIZE      16
-#define AES_ROUNDS          10  // 12, 14
+#define AES_ROUNDS          10
 #define AES_ROUND_KEY_SIZE  176 // AES-128 has 10 rounds, and there is a AddRoundKey before first round. (10+1)x16=176.
+#define AES_192_ROUNDS      12
+#define AES_192_ROUND_KEY_SIZE  208 // (12+1)x16
+#define AES_256_ROUNDS      14
+#define AES_256_ROUND_KEY_SIZE  240 // (14+1)x16
 
 /**
  * @purpose:            Decryption. The length of plain and cipher should be one block (16 bytes).
@@ -26,4 +32,39 @@
  * @par[out]plaintext:  plain text
  */
 void aes_decrypt_128( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+/**
+ * @purpose:            Byte-wise engine behind aes_decrypt_128 when AES-NI is not used.
+ *                      Always available, e.g. to cross-check the other engines.
+ */
+void aes_decrypt_128_byte( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+/**
+ * @purpose:            Word-state engine behind aes_decrypt_128 for the portable builds
+ *                      (AES_ENGINE_WORD and AES_ENGINE_TTABLE, or AUTO without AES-NI/SSSE3).
+ *                      Uses the encryption round keys and the 256-byte INV_SBOX only.
+ */
+void aes_decrypt_128_word( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+/**
+ * @purpose:            AES-192 and AES-256 decryption, same contract as aes_decrypt_128 and
+ *                      the same AES_ENGINE selection. The round keys come from
+ *                      aes_key_schedule_192/aes_key_schedule_256.
+ */
+void aes_decrypt_192( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+void aes_decrypt_256( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+/**
+ * @purpose:            AES-128 decryption from the last round key alone, which
+ *                      aes_key_schedule_128_last computes once from the master key. The
+ *                      schedule is inverted one round at a time in a 16-byte buffer while
+ *                      decrypting, so no schedule is stored. The counterpart of
+ *                      aes_encrypt_128_otf, with the same engine selection.
+ * @par[in]lastkey:     16 bytes, round key 10
+ * @par[in]ciphertext:  cipher text
+ * @par[out]plaintext:  plain text
+ */
+void aes_decrypt_128_otf(const uint8_t *lastkey, uint8_t *ciphertext, uint8_t *plaintext);
+void aes_decrypt_128_byte_otf(const uint8_t *lastkey, uint8_t *ciphertext, uint8_t *plaintext);
+void aes_decrypt_128_word_otf(const uint8_t *lastkey, uint8_t *ciphertext, uint8_t *plaintext);
+void aes_decrypt_192_byte( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+void aes_decrypt_256_byte( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+void aes_decrypt_192_word( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+void aes_decrypt_256_word( uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
 #endif
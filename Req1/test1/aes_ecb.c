@@ -0,0 +1,77 @@
+/*
+ * aes_ecb.c
+ *
+ * Multi-block ECB, see aes_ecb.h.
+ *
+ */
+#include <stdint.h>
+#include "aes_config.h"
+#include "aes_key.h"
+#include "aes_ecb.h"
+#include "aes_schedule.h"
+#include "aes_encrypt.h"
+#include "aes_decrypt.h"
+#include "aes_ttable.h"
+#include "aes_aesni.h"
+#include "aes_bitslice.h"
+#include "aes_engine.h"
+
+// the bitsliced engine always does 8 blocks, a shorter run pads and loses to the single-block loop
+#define ECB_BS_MIN      8
+
+typedef void (*ecb_block_fn)(uint8_t *roundkeys, uint8_t *in, uint8_t *out);
+
+static void ecb_loop(ecb_block_fn fn, const uint8_t *roundkeys, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+    for (; nblocks > 0; --nblocks, in += AES_BLOCK_SIZE, out += AES_BLOCK_SIZE) {
+        fn((uint8_t *)roundkeys, (uint8_t *)in, out);
+    }
+}
+
+void aes_ecb_encrypt_blocks(const aes_key_ctx *ctx, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+#if AES_ENGINE == AES_ENGINE_AUTO
+#if AES_HAVE_AESNI
+    if (aes_cpu_has_aesni()) {
+        aes_encrypt_128_aesni_blocks((uint8_t *)ctx->enc, in, out, nblocks);
+        return;
+    }
+#endif
+#if AES_HAVE_SSE2
+    if (nblocks >= ECB_BS_MIN) {
+        aes_encrypt_128_bs8_blocks(ctx->bs, in, out, nblocks);
+        return;
+    }
+#endif
+    ecb_loop(AES_ENGINE_GET(aes_encrypt_engine[AES_ENGINE_128]), ctx->enc, in, out, nblocks);
+#elif AES_ENGINE == AES_ENGINE_TTABLE
+    ecb_loop(aes_encrypt_128_ttable, ctx->enc, in, out, nblocks);
+#elif AES_ENGINE == AES_ENGINE_WORD
+    ecb_loop(aes_encrypt_128_word, ctx->enc, in, out, nblocks);
+#else
+    ecb_loop(aes_encrypt_128_byte, ctx->enc, in, out, nblocks);
+#endif
+}
+
+void aes_ecb_decrypt_blocks(const aes_key_ctx *ctx, const uint8_t *in, uint8_t *out, uint32_t nblocks) {
+#if AES_ENGINE == AES_ENGINE_AUTO
+#if AES_HAVE_AESNI
+    if (aes_cpu_has_aesni()) {
+        aes_decrypt_128_aesni_blocks((uint8_t *)ctx->enc, in, out, nblocks);
+        return;
+    }
+#endif
+#if AES_HAVE_SSE2
+    if (nblocks >= ECB_BS_MIN) {
+        aes_decrypt_128_bs8_blocks(ctx->bs, in, out, nblocks);
+        return;
+    }
+#endif
+    ecb_loop(AES_ENGINE_GET(aes_decrypt_engine[AES_ENGINE_128]), ctx->enc, in, out, nblocks);
+#elif AES_ENGINE == AES_ENGINE_TTABLE
+    // the context already holds the equivalent inverse cipher's round keys
+    ecb_loop(aes_decrypt_128_ttable, ctx->dec, in, out, nblocks);
+#elif AES_ENGINE == AES_ENGINE_WORD
+    ecb_loop(aes_decrypt_128_word, ctx->enc, in, out, nblocks);
+#else
+    ecb_loop(aes_decrypt_128_byte, ctx->enc, in, out, nblocks);
+#endif
+}
@@ -0,0 +1,27 @@
+/*
+ * aes_ecb.h
+ *
+ * Multi-block ECB on a key context, the base of the parallel modes. Each call
+ * hands the whole run to the widest engine the build and the CPU offer:
+ * with AES_ENGINE_AUTO the interleaved AES-NI kernels, else the bitsliced
+ * engine for runs of 8 blocks and more, else a tight loop over the bound
+ * single-block engine. Other AES_ENGINE settings loop over their engine
+ * directly, without the per-block dispatch of aes_encrypt_128.
+ *
+ */
+#ifndef AES_ECB_H
+#define AES_ECB_H
+#include <stdint.h>
+#include "aes_config.h"
+#include "aes_key.h"
+
+/**
+ * @purpose:            Encrypt / decrypt nblocks independent blocks.
+ * @par[in]ctx:         expanded key from aes_key_ctx_init
+ * @par[in]in:          nblocks * 16 bytes of input
+ * @par[out]out:        nblocks * 16 bytes of output, may be the same as in
+ * @par[in]nblocks:     number of blocks, 0 is allowed
+ */
+void aes_ecb_encrypt_blocks(const aes_key_ctx *ctx, const uint8_t *in, uint8_t *out, uint32_t nblocks);
+void aes_ecb_decrypt_blocks(const aes_key_ctx *ctx, const uint8_t *in, uint8_t *out, uint32_t nblocks);
+#endif
@@ -12,7 +12,13 @@
  *
  */
 #include <stdint.h>
+#include "aes_config.h"
+#include "aes_gf.h"
 #include "aes_encrypt.h"
+#include "aes_schedule.h"
+#include "aes_ttable.h"
+#include "aes_engine.h"
+#if !AES_SBOX_COMPUTED
 /*
  * Sbox
  */
@@ -33,18 +39,9 @@
     0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
     0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
     0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16};
+#endif
 
 
-/**
- * https://en.wikipedia.org/wiki/Finite_field_arithmetic
- * Multiply two numbers in the GF(2^8) finite field defined
- * by the polynomial x^8 + x^4 + x^3 + x + 1 = 0
- * We do use mul2(int8_t a) but not mul(uint8_t a, uint8_t b)
- * just in order to get a higher speed.
- */
-static inline uint8_t mul2(uint8_t a) {
-    return (a&0x80) ? ((a<<1)^0x1b) : (a<<1);
-}
 /**
  * @purpose:    ShiftRows
  * @descrption:
@@ -76,7 +73,13 @@ static void shift_rows(uint8_t *state) {
     *(state+3)  = temp;
 }
 
- void aes_encrypt_128( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext) {
+/*
+ * With otf set, roundkeys is a 16-byte buffer holding the AES-128 master key
+ * and each round key is derived in it just before it is added, so that the
+ * cipher never needs the 176-byte schedule.
+ */
+static AES_FORCE_INLINE void encrypt_byte( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext, const uint8_t rounds,
+                                           const uint8_t otf) {
 
     uint8_t tmp[16], t;
     uint8_t i, j;
@@ -86,13 +89,20 @@ static void shift_rows(uint8_t *state) {
         *(ciphertext+i) = *(plaintext+i) ^ *roundkeys++;
     }
 
-    // 9 rounds
-    for (j = 1; j < AES_ROUNDS; ++j) {
+    // 9, 11 or 13 rounds
+    for (j = 1; j < rounds; ++j) {
 
         // SubBytes
+#if AES_SBOX_COMPUTED
+        for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+            *(tmp+i) = *(ciphertext+i);
+        }
+        aes_gf_sub_bytes(tmp, AES_BLOCK_SIZE);
+#else
         for (i = 0; i < AES_BLOCK_SIZE; ++i) {
             *(tmp+i) = SBOX[*(ciphertext+i)];
         }
+#endif
         shift_rows(tmp);
         /*
          * MixColumns 
@@ -103,13 +113,17 @@ static void shift_rows(uint8_t *state) {
          */
         for (i = 0; i < AES_BLOCK_SIZE; i+=4)  {
             t = tmp[i] ^ tmp[i+1] ^ tmp[i+2] ^ tmp[i+3];
-            ciphertext[i]   = mul2(tmp[i]   ^ tmp[i+1]) ^ tmp[i]   ^ t;
-            ciphertext[i+1] = mul2(tmp[i+1] ^ tmp[i+2]) ^ tmp[i+1] ^ t;
-            ciphertext[i+2] = mul2(tmp[i+2] ^ tmp[i+3]) ^ tmp[i+2] ^ t;
-            ciphertext[i+3] = mul2(tmp[i+3] ^ tmp[i]  ) ^ tmp[i+3] ^ t;
+            ciphertext[i]   = gf_xtime(tmp[i]   ^ tmp[i+1]) ^ tmp[i]   ^ t;
+            ciphertext[i+1] = gf_xtime(tmp[i+1] ^ tmp[i+2]) ^ tmp[i+1] ^ t;
+            ciphertext[i+2] = gf_xtime(tmp[i+2] ^ tmp[i+3]) ^ tmp[i+2] ^ t;
+            ciphertext[i+3] = gf_xtime(tmp[i+3] ^ tmp[i]  ) ^ tmp[i+3] ^ t;
         }
 
         // AddRoundKey
+        if (otf) {
+            roundkeys -= 16;
+            aes_key_schedule_128_next(roundkeys, j);
+        }
         for ( i = 0; i < AES_BLOCK_SIZE; ++i ) {
             *(ciphertext+i) ^= *roundkeys++;
         }
@@ -117,12 +131,191 @@ static void shift_rows(uint8_t *state) {
     }
     
     // last round
+#if AES_SBOX_COMPUTED
+    aes_gf_sub_bytes(ciphertext, AES_BLOCK_SIZE);
+#else
     for (i = 0; i < AES_BLOCK_SIZE; ++i) {
         *(ciphertext+i) = SBOX[*(ciphertext+i)];
     }
+#endif
     shift_rows(ciphertext);
+    if (otf) {
+        roundkeys -= 16;
+        aes_key_schedule_128_next(roundkeys, rounds);
+    }
     for ( i = 0; i < AES_BLOCK_SIZE; ++i ) {
         *(ciphertext+i) ^= *roundkeys++;
     }
 
 }
+
+ void aes_encrypt_128_byte( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext) {
+    encrypt_byte(roundkeys, plaintext, ciphertext, AES_ROUNDS, 0);
+}
+
+ void aes_encrypt_192_byte( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext) {
+    encrypt_byte(roundkeys, plaintext, ciphertext, AES_192_ROUNDS, 0);
+}
+
+ void aes_encrypt_256_byte( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext) {
+    encrypt_byte(roundkeys, plaintext, ciphertext, AES_256_ROUNDS, 0);
+}
+
+#if AES_SBOX_COMPUTED
+/*
+ * SubBytes runs on the whole state first, ShiftRows is then a byte select:
+ * row r of output column c comes from input column c + r.
+ */
+#define SUB_STATE(s0, s1, s2, s3)   sub_state(&(s0), &(s1), &(s2), &(s3))
+#define SUB_SHIFT_WORD(w0, w1, w2, w3) \
+    (((w0) & 0xff) ^ ((w1) & 0xff00) ^ ((w2) & 0xff0000) ^ ((w3) & 0xff000000))
+
+static void sub_state(uint32_t *s0, uint32_t *s1, uint32_t *s2, uint32_t *s3) {
+
+    uint8_t b[AES_BLOCK_SIZE];
+
+    gf_store_word(b     , *s0);
+    gf_store_word(b +  4, *s1);
+    gf_store_word(b +  8, *s2);
+    gf_store_word(b + 12, *s3);
+    aes_gf_sub_bytes(b, AES_BLOCK_SIZE);
+    *s0 = gf_load_word(b     );
+    *s1 = gf_load_word(b +  4);
+    *s2 = gf_load_word(b +  8);
+    *s3 = gf_load_word(b + 12);
+}
+#else
+/*
+ * SubBytes and ShiftRows in one pass: row r of output column c comes from
+ * input column c + r.
+ */
+#define SUB_STATE(s0, s1, s2, s3)
+#define SUB_SHIFT_WORD(w0, w1, w2, w3) \
+    ((uint32_t)SBOX[(w0) & 0xff] ^ ((uint32_t)SBOX[((w1) >> 8) & 0xff] << 8) ^ \
+     ((uint32_t)SBOX[((w2) >> 16) & 0xff] << 16) ^ ((uint32_t)SBOX[(w3) >> 24] << 24))
+#endif
+
+static AES_FORCE_INLINE void encrypt_word( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext, const uint8_t rounds,
+                                           const uint8_t otf) {
+
+    uint32_t s0, s1, s2, s3, t0, t1, t2, t3;
+    uint8_t j;
+
+    // first AddRoundKey
+    s0 = gf_load_word(plaintext     ) ^ gf_load_word(roundkeys     );
+    s1 = gf_load_word(plaintext +  4) ^ gf_load_word(roundkeys +  4);
+    s2 = gf_load_word(plaintext +  8) ^ gf_load_word(roundkeys +  8);
+    s3 = gf_load_word(plaintext + 12) ^ gf_load_word(roundkeys + 12);
+
+    // 9, 11 or 13 rounds
+    for (j = 1; j < rounds; ++j) {
+        if (otf) {
+            aes_key_schedule_128_next(roundkeys, j);
+        } else {
+            roundkeys += 16;
+        }
+        SUB_STATE(s0, s1, s2, s3);
+        t0 = SUB_SHIFT_WORD(s0, s1, s2, s3);
+        t1 = SUB_SHIFT_WORD(s1, s2, s3, s0);
+        t2 = SUB_SHIFT_WORD(s2, s3, s0, s1);
+        t3 = SUB_SHIFT_WORD(s3, s0, s1, s2);
+        s0 = gf_mix_column_word(t0) ^ gf_load_word(roundkeys     );
+        s1 = gf_mix_column_word(t1) ^ gf_load_word(roundkeys +  4);
+        s2 = gf_mix_column_word(t2) ^ gf_load_word(roundkeys +  8);
+        s3 = gf_mix_column_word(t3) ^ gf_load_word(roundkeys + 12);
+    }
+
+    // last round
+    if (otf) {
+        aes_key_schedule_128_next(roundkeys, rounds);
+    } else {
+        roundkeys += 16;
+    }
+    SUB_STATE(s0, s1, s2, s3);
+    t0 = SUB_SHIFT_WORD(s0, s1, s2, s3) ^ gf_load_word(roundkeys     );
+    t1 = SUB_SHIFT_WORD(s1, s2, s3, s0) ^ gf_load_word(roundkeys +  4);
+    t2 = SUB_SHIFT_WORD(s2, s3, s0, s1) ^ gf_load_word(roundkeys +  8);
+    t3 = SUB_SHIFT_WORD(s3, s0, s1, s2) ^ gf_load_word(roundkeys + 12);
+    gf_store_word(ciphertext     , t0);
+    gf_store_word(ciphertext +  4, t1);
+    gf_store_word(ciphertext +  8, t2);
+    gf_store_word(ciphertext + 12, t3);
+}
+
+void aes_encrypt_128_word( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext) {
+    encrypt_word(roundkeys, plaintext, ciphertext, AES_ROUNDS, 0);
+}
+
+void aes_encrypt_192_word( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext) {
+    encrypt_word(roundkeys, plaintext, ciphertext, AES_192_ROUNDS, 0);
+}
+
+void aes_encrypt_256_word( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext) {
+    encrypt_word(roundkeys, plaintext, ciphertext, AES_256_ROUNDS, 0);
+}
+
+void aes_encrypt_128_byte_otf(const uint8_t *key, uint8_t *plaintext, uint8_t *ciphertext) {
+
+    uint8_t roundkey[AES_BLOCK_SIZE];
+    uint8_t i;
+
+    for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+        roundkey[i] = key[i];
+    }
+    encrypt_byte(roundkey, plaintext, ciphertext, AES_ROUNDS, 1);
+}
+
+void aes_encrypt_128_word_otf(const uint8_t *key, uint8_t *plaintext, uint8_t *ciphertext) {
+
+    uint8_t roundkey[AES_BLOCK_SIZE];
+    uint8_t i;
+
+    for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+        roundkey[i] = key[i];
+    }
+    encrypt_word(roundkey, plaintext, ciphertext, AES_ROUNDS, 1);
+}
+
+void aes_encrypt_128_otf(const uint8_t *key, uint8_t *plaintext, uint8_t *ciphertext) {
+#if AES_ENGINE == AES_ENGINE_BYTE
+    aes_encrypt_128_byte_otf(key, plaintext, ciphertext);
+#else
+    aes_encrypt_128_word_otf(key, plaintext, ciphertext);
+#endif
+}
+
+void aes_encrypt_128( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext) {
+#if AES_ENGINE == AES_ENGINE_AUTO
+    AES_ENGINE_GET(aes_encrypt_engine[AES_ENGINE_128])(roundkeys, plaintext, ciphertext);
+#elif AES_ENGINE == AES_ENGINE_TTABLE
+    aes_encrypt_128_ttable(roundkeys, plaintext, ciphertext);
+#elif AES_ENGINE == AES_ENGINE_WORD
+    aes_encrypt_128_word(roundkeys, plaintext, ciphertext);
+#else
+    aes_encrypt_128_byte(roundkeys, plaintext, ciphertext);
+#endif
+}
+
+void aes_encrypt_192( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext) {
+#if AES_ENGINE == AES_ENGINE_AUTO
+    AES_ENGINE_GET(aes_encrypt_engine[AES_ENGINE_192])(roundkeys, plaintext, ciphertext);
+#elif AES_ENGINE == AES_ENGINE_TTABLE
+    aes_encrypt_192_ttable(roundkeys, plaintext, ciphertext);
+#elif AES_ENGINE == AES_ENGINE_WORD
+    aes_encrypt_192_word(roundkeys, plaintext, ciphertext);
+#else
+    aes_encrypt_192_byte(roundkeys, plaintext, ciphertext);
+#endif
+}
+
+void aes_encrypt_256( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext) {
+#if AES_ENGINE == AES_ENGINE_AUTO
+    AES_ENGINE_GET(aes_encrypt_engine[AES_ENGINE_256])(roundkeys, plaintext, ciphertext);
+#elif AES_ENGINE == AES_ENGINE_TTABLE
+    aes_encrypt_256_ttable(roundkeys, plaintext, ciphertext);
+#elif AES_ENGINE == AES_ENGINE_WORD
+    aes_encrypt_256_word(roundkeys, plaintext, ciphertext);
+#else
+    aes_encrypt_256_byte(roundkeys, plaintext, ciphertext);
+#endif
+}
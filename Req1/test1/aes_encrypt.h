@@ -17,8 +17,12 @@
 extern uint8_t SBOX[256];
 
 #define AES_BLOCK_SIZE      16
-#define AES_ROUNDS          10  // 12, 14
+#define AES_ROUNDS          10
 #define AES_ROUND_KEY_SIZE  176 // AES-128 has 10 rounds, and there is a AddRoundKey before first round. (10+1)x16=176.
+#define AES_192_ROUNDS      12
+#define AES_192_ROUND_KEY_SIZE  208 // (12+1)x16
+#define AES_256_ROUNDS      14
+#define AES_256_ROUND_KEY_SIZE  240 // (14+1)x16
 /**
  * @purpose:            Encryption. The length of plain and cipher should be one block (16 bytes).
  *                      The plaintext and ciphertext may point to the same memory
@@ -27,4 +31,39 @@ extern uint8_t SBOX[256];
  * @par[out]ciphertext: cipher text
  */
  void aes_encrypt_128( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext);
+/**
+ * @purpose:            Byte-wise engine behind aes_encrypt_128 when AES_ENGINE is AES_ENGINE_BYTE.
+ *                      Always available, e.g. to cross-check the other engines.
+ */
+ void aes_encrypt_128_byte( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext);
+/**
+ * @purpose:            Word-state engine behind aes_encrypt_128 when AES_ENGINE is AES_ENGINE_WORD.
+ *                      Columns are 32-bit words and MixColumns is SWAR arithmetic on them;
+ *                      only the 256-byte SBOX is used.
+ */
+ void aes_encrypt_128_word( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext);
+/**
+ * @purpose:            AES-192 and AES-256 encryption, same contract as aes_encrypt_128 and
+ *                      the same AES_ENGINE selection. The round keys come from
+ *                      aes_key_schedule_192/aes_key_schedule_256.
+ */
+ void aes_encrypt_192( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext);
+ void aes_encrypt_256( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext);
+/**
+ * @purpose:            AES-128 encryption straight from the master key. Each round key is
+ *                      derived in a 16-byte buffer while the rounds run, so no schedule is
+ *                      stored: a one-pass rekey and encrypt for short-lived keys, and 160
+ *                      bytes less RAM than aes_key_schedule_128 + aes_encrypt_128.
+ *                      The byte engine with AES_ENGINE_BYTE, the word engine otherwise.
+ * @par[in]key:         16 bytes of master key
+ * @par[in]plaintext:   plain text
+ * @par[out]ciphertext: cipher text
+ */
+ void aes_encrypt_128_otf(const uint8_t *key, uint8_t *plaintext, uint8_t *ciphertext);
+ void aes_encrypt_128_byte_otf(const uint8_t *key, uint8_t *plaintext, uint8_t *ciphertext);
+ void aes_encrypt_128_word_otf(const uint8_t *key, uint8_t *plaintext, uint8_t *ciphertext);
+ void aes_encrypt_192_byte( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext);
+ void aes_encrypt_256_byte( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext);
+ void aes_encrypt_192_word( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext);
+ void aes_encrypt_256_word( uint8_t *roundkeys,  uint8_t *plaintext,  uint8_t *ciphertext);
 #endif
@@ -0,0 +1,331 @@
+/*
+ * aes_engine.c
+ *
+ * Engine registry and startup autotuner for AES_ENGINE_AUTO, see aes_engine.h.
+ * Built empty for the other engine settings, so the AVR project does not pull
+ * in stdio or the clock.
+ *
+ */
+#include <stdint.h>
+#include "aes_config.h"
+
+#if AES_ENGINE == AES_ENGINE_AUTO
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if AES_HAVE_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include "aes_engine.h"
+#include "aes_encrypt.h"
+#include "aes_decrypt.h"
+#include "aes_schedule.h"
+#include "aes_ttable.h"
+#include "aes_aesni.h"
+#include "aes_vperm.h"
+
+#define TUNE_BATCH      64      // blocks between two clock reads
+#define TUNE_SECONDS    1e-3    // per engine and direction
+
+typedef struct {
+    const char *name;
+    int (*available)(void);     // NULL if every CPU can run it
+    aes_block_fn encrypt[3];
+    aes_block_fn decrypt[3];    // NULL if there is no kernel for the common round keys
+} engine_entry;
+
+/*
+ * Ties go to the earlier entry. The T-table decryption needs the round keys of
+ * aes_key_schedule_128_dec, so it only competes for encryption. The bitsliced
+ * engine needs 8 blocks per call and is not a single-block candidate.
+ */
+static const engine_entry ENGINES[] = {
+#if AES_HAVE_AESNI
+    {"aesni", aes_cpu_has_aesni,
+        {aes_encrypt_128_aesni, aes_encrypt_192_aesni, aes_encrypt_256_aesni},
+        {aes_decrypt_128_aesni, aes_decrypt_192_aesni, aes_decrypt_256_aesni}},
+#endif
+#if AES_HAVE_SSSE3
+    {"vperm", aes_cpu_has_ssse3,
+        {aes_encrypt_128_vperm, aes_encrypt_192_vperm, aes_encrypt_256_vperm},
+        {aes_decrypt_128_vperm, aes_decrypt_192_vperm, aes_decrypt_256_vperm}},
+#endif
+    {"ttable", NULL,
+        {aes_encrypt_128_ttable, aes_encrypt_192_ttable, aes_encrypt_256_ttable},
+        {NULL, NULL, NULL}},
+    {"word", NULL,
+        {aes_encrypt_128_word, aes_encrypt_192_word, aes_encrypt_256_word},
+        {aes_decrypt_128_word, aes_decrypt_192_word, aes_decrypt_256_word}},
+    {"byte", NULL,
+        {aes_encrypt_128_byte, aes_encrypt_192_byte, aes_encrypt_256_byte},
+        {aes_decrypt_128_byte, aes_decrypt_192_byte, aes_decrypt_256_byte}},
+};
+
+#define ENGINE_COUNT    ((int)(sizeof(ENGINES) / sizeof(ENGINES[0])))
+
+static void encrypt_128_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out);
+static void encrypt_192_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out);
+static void encrypt_256_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out);
+static void decrypt_128_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out);
+static void decrypt_192_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out);
+static void decrypt_256_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out);
+
+aes_block_fn aes_encrypt_engine[3] = {encrypt_128_first, encrypt_192_first, encrypt_256_first};
+aes_block_fn aes_decrypt_engine[3] = {decrypt_128_first, decrypt_192_first, decrypt_256_first};
+
+static int bound[2] = {-1, -1};
+static int forced;                  // bit per direction bound by aes_engine_force
+
+static double now(void) {
+#if defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static int usable(int index, int dir) {
+    const engine_entry *e = &ENGINES[index];
+
+    if (e->available != NULL && !e->available()) {
+        return 0;
+    }
+    return (dir == AES_ENGINE_ENCRYPT ? e->encrypt[0] : e->decrypt[0]) != NULL;
+}
+
+static void bind(int index, int dir) {
+    const aes_block_fn *fn = dir == AES_ENGINE_ENCRYPT ? ENGINES[index].encrypt : ENGINES[index].decrypt;
+    aes_block_fn *engine = dir == AES_ENGINE_ENCRYPT ? aes_encrypt_engine : aes_decrypt_engine;
+
+    AES_ENGINE_SET(engine[AES_ENGINE_128], fn[AES_ENGINE_128]);
+    AES_ENGINE_SET(engine[AES_ENGINE_192], fn[AES_ENGINE_192]);
+    AES_ENGINE_SET(engine[AES_ENGINE_256], fn[AES_ENGINE_256]);
+    AES_ENGINE_SET(bound[dir], index);
+}
+
+/**
+ * @purpose:    Blocks per second of one AES-128 kernel, chained so that the
+ *              calls cannot overlap. One untimed call loads its tables first.
+ */
+static double measure(aes_block_fn fn) {
+    uint8_t roundkeys[AES_ROUND_KEY_SIZE];
+    uint8_t block[AES_BLOCK_SIZE];
+    unsigned long blocks = 0;
+    double start, t;
+    uint8_t i;
+
+    memset(block, 0, sizeof(block));
+    aes_key_schedule_128_byte(block, roundkeys);
+    fn(roundkeys, block, block);
+
+    start = now();
+    do {
+        for (i = 0; i < TUNE_BATCH; ++i) {
+            fn(roundkeys, block, block);
+        }
+        blocks += TUNE_BATCH;
+        t = now() - start;
+    } while (t < TUNE_SECONDS);
+    return blocks / t;
+}
+
+static void tune(int dir) {
+    double rate, best_rate = 0;
+    int i, best = -1;
+
+    for (i = 0; i < ENGINE_COUNT; ++i) {
+        if (!usable(i, dir)) {
+            continue;
+        }
+        rate = measure(dir == AES_ENGINE_ENCRYPT ? ENGINES[i].encrypt[0] : ENGINES[i].decrypt[0]);
+        if (best < 0 || rate > best_rate) {
+            best = i;
+            best_rate = rate;
+        }
+    }
+    bind(best, dir);
+}
+
+static int bind_name(int dir, const char *name) {
+    int i;
+
+    for (i = 0; i < ENGINE_COUNT; ++i) {
+        if (strcmp(ENGINES[i].name, name) == 0) {
+            if (!usable(i, dir)) {
+                return -1;
+            }
+            bind(i, dir);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * The cache file is one "encrypt <name>" and one "decrypt <name>" line. A line
+ * naming an engine this CPU cannot run is ignored and that direction is timed.
+ * Directions in skip are left as they are.
+ */
+static int load_cache(const char *path, int skip) {
+    char dir[16], name[16];
+    int found = 0;
+    FILE *f;
+
+    f = fopen(path, "r");
+    if (f == NULL) {
+        return 0;
+    }
+    while (fscanf(f, "%15s %15s", dir, name) == 2) {
+        if (strcmp(dir, "encrypt") == 0 && !(skip & (1 << AES_ENGINE_ENCRYPT)) &&
+            bind_name(AES_ENGINE_ENCRYPT, name) == 0) {
+            found |= 1 << AES_ENGINE_ENCRYPT;
+        } else if (strcmp(dir, "decrypt") == 0 && !(skip & (1 << AES_ENGINE_DECRYPT)) &&
+                   bind_name(AES_ENGINE_DECRYPT, name) == 0) {
+            found |= 1 << AES_ENGINE_DECRYPT;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+/*
+ * Written next to the file and renamed over it, so a process starting at the
+ * same time reads either the old decision or the new one, never a partial file
+ */
+static void save_cache(const char *path) {
+    char *tmp;
+    FILE *f;
+    int ok;
+
+    tmp = malloc(strlen(path) + 24);
+    if (tmp == NULL) {
+        return;
+    }
+#if AES_HAVE_PTHREAD
+    sprintf(tmp, "%s.%lu.tmp", path, (unsigned long)getpid());
+#else
+    sprintf(tmp, "%s.tmp", path);
+#endif
+    // a read-only location only costs the next process a new measurement
+    f = fopen(tmp, "w");
+    if (f != NULL) {
+        ok = fprintf(f, "encrypt %s\ndecrypt %s\n", ENGINES[AES_ENGINE_GET(bound[AES_ENGINE_ENCRYPT])].name,
+                     ENGINES[AES_ENGINE_GET(bound[AES_ENGINE_DECRYPT])].name) > 0;
+        ok = fclose(f) == 0 && ok;
+        if (!ok || rename(tmp, path) != 0) {
+            remove(tmp);
+        }
+    }
+    free(tmp);
+}
+
+/*
+ * A forced direction keeps its engine. It is also kept out of the cache file,
+ * which only records measured decisions, so nothing is saved while one is set.
+ */
+void aes_engine_autotune(const char *cache_path) {
+    int keep = AES_ENGINE_GET(forced);
+    int found = cache_path != NULL ? load_cache(cache_path, keep) : 0;
+    int done = keep | found;
+
+    if (!(done & (1 << AES_ENGINE_ENCRYPT))) {
+        tune(AES_ENGINE_ENCRYPT);
+    }
+    if (!(done & (1 << AES_ENGINE_DECRYPT))) {
+        tune(AES_ENGINE_DECRYPT);
+    }
+    if (cache_path != NULL && keep == 0 && found != ((1 << AES_ENGINE_ENCRYPT) | (1 << AES_ENGINE_DECRYPT))) {
+        save_cache(cache_path);
+    }
+}
+
+static void autotune_env(void) {
+    aes_engine_autotune(getenv("AES_ENGINE_CACHE"));
+}
+
+/*
+ * The first call of any key size tunes both directions for all of them.
+ * Threads making their first call at the same time wait for one tuning run.
+ */
+#if AES_HAVE_PTHREAD
+static pthread_once_t tune_once = PTHREAD_ONCE_INIT;
+
+static void autotune_once(void) {
+    pthread_once(&tune_once, autotune_env);
+}
+#else
+static void autotune_once(void) {
+    autotune_env();
+}
+#endif
+
+static void encrypt_128_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out) {
+    autotune_once();
+    AES_ENGINE_GET(aes_encrypt_engine[AES_ENGINE_128])(roundkeys, in, out);
+}
+
+static void encrypt_192_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out) {
+    autotune_once();
+    AES_ENGINE_GET(aes_encrypt_engine[AES_ENGINE_192])(roundkeys, in, out);
+}
+
+static void encrypt_256_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out) {
+    autotune_once();
+    AES_ENGINE_GET(aes_encrypt_engine[AES_ENGINE_256])(roundkeys, in, out);
+}
+
+static void decrypt_128_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out) {
+    autotune_once();
+    AES_ENGINE_GET(aes_decrypt_engine[AES_ENGINE_128])(roundkeys, in, out);
+}
+
+static void decrypt_192_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out) {
+    autotune_once();
+    AES_ENGINE_GET(aes_decrypt_engine[AES_ENGINE_192])(roundkeys, in, out);
+}
+
+static void decrypt_256_first(uint8_t *roundkeys, uint8_t *in, uint8_t *out) {
+    autotune_once();
+    AES_ENGINE_GET(aes_decrypt_engine[AES_ENGINE_256])(roundkeys, in, out);
+}
+
+const char *aes_engine_selected(int dir) {
+    if (AES_ENGINE_GET(bound[dir]) < 0) {
+        autotune_once();
+    }
+    return ENGINES[AES_ENGINE_GET(bound[dir])].name;
+}
+
+int aes_engine_force(int dir, const char *name) {
+    if (name == NULL) {
+#if defined(__GNUC__)
+        __atomic_fetch_and(&forced, ~(1 << dir), __ATOMIC_RELEASE);
+#else
+        forced &= ~(1 << dir);
+#endif
+        return 0;
+    }
+    if (bind_name(dir, name) != 0) {
+        return -1;
+    }
+#if defined(__GNUC__)
+    __atomic_fetch_or(&forced, 1 << dir, __ATOMIC_RELEASE);
+#else
+    forced |= 1 << dir;
+#endif
+    return 0;
+}
+
+int aes_engine_count(void) {
+    return ENGINE_COUNT;
+}
+
+const char *aes_engine_name(int index) {
+    return index >= 0 && index < ENGINE_COUNT ? ENGINES[index].name : NULL;
+}
+
+#endif
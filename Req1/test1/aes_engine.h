@@ -0,0 +1,78 @@
+/*
+ * aes_engine.h
+ *
+ * Engine registry behind aes_encrypt_* and aes_decrypt_* when AES_ENGINE is
+ * AES_ENGINE_AUTO. On first use every engine this CPU can run is timed for about
+ * a millisecond and the fastest one is bound, separately for each direction.
+ * Set AES_ENGINE_CACHE to a file name to keep that decision across runs.
+ *
+ */
+#ifndef AES_ENGINE_H
+#define AES_ENGINE_H
+#include <stdint.h>
+#include "aes_config.h"
+
+#if AES_ENGINE == AES_ENGINE_AUTO
+
+#define AES_ENGINE_ENCRYPT  0
+#define AES_ENGINE_DECRYPT  1
+
+#define AES_ENGINE_128      0
+#define AES_ENGINE_192      1
+#define AES_ENGINE_256      2
+
+typedef void (*aes_block_fn)(uint8_t *roundkeys, uint8_t *in, uint8_t *out);
+
+/*
+ * Bound engines, indexed by AES_ENGINE_128/192/256. Until the first call they
+ * point to stubs that run aes_engine_autotune. Other threads may be calling
+ * through a slot while it is rebound, so go through AES_ENGINE_GET.
+ */
+extern aes_block_fn aes_encrypt_engine[3];
+extern aes_block_fn aes_decrypt_engine[3];
+
+#if defined(__GNUC__)
+#define AES_ENGINE_GET(slot)        __atomic_load_n(&(slot), __ATOMIC_ACQUIRE)
+#define AES_ENGINE_SET(slot, fn)    __atomic_store_n(&(slot), (fn), __ATOMIC_RELEASE)
+#else
+#define AES_ENGINE_GET(slot)        (slot)
+#define AES_ENGINE_SET(slot, fn)    ((slot) = (fn))
+#endif
+
+/**
+ * @purpose:            Pick and bind the engines now. Reads the decision from cache_path if
+ *                      the file names engines this CPU can run, otherwise times all of them
+ *                      and writes the result to cache_path. Directions bound with
+ *                      aes_engine_force keep their engine and are not written.
+ * @par[in]cache_path:  decision file, or NULL to always time the engines
+ */
+void aes_engine_autotune(const char *cache_path);
+
+/**
+ * @purpose:            Name of the engine bound for a direction, e.g. "aesni", "vperm",
+ *                      "ttable", "word" or "byte". Runs the autotuner if nothing is bound yet.
+ * @par[in]dir:         AES_ENGINE_ENCRYPT or AES_ENGINE_DECRYPT
+ */
+const char *aes_engine_selected(int dir);
+
+/**
+ * @purpose:            Bind an engine by name, bypassing the measurement. The direction stays
+ *                      bound to it, neither the first call nor aes_engine_autotune retunes it.
+ * @par[in]dir:         AES_ENGINE_ENCRYPT or AES_ENGINE_DECRYPT
+ * @par[in]name:        engine name as returned by aes_engine_name, or NULL to keep the current
+ *                      engine but let the next aes_engine_autotune pick again
+ * @return:             0 on success, -1 if the engine is unknown, cannot run on this CPU
+ *                      or has no kernel for this direction
+ */
+int aes_engine_force(int dir, const char *name);
+
+/**
+ * @purpose:            Enumerate the registry, including engines this CPU cannot run.
+ * @par[in]index:       0 .. aes_engine_count()-1
+ * @return:             engine name, or NULL past the end
+ */
+int aes_engine_count(void);
+const char *aes_engine_name(int index);
+
+#endif
+#endif
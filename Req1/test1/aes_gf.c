@@ -0,0 +1,252 @@
+/*
+ * aes_gf.c
+ *
+ * Out-of-line GF(2^8) and GF(2^128) helpers, see aes_gf.h.
+ *
+ */
+#include <stdint.h>
+#include "aes_gf.h"
+
+/*
+ * Boyar-Peralta S-box circuit on eight bit planes, plane k holding bit k of
+ * eight bytes (the same circuit as fs_sbox of the ARM fixsliced engine).
+ * x0 is the most significant bit.
+ */
+static void gf_sbox_planes(uint8_t *q) {
+    uint8_t x0, x1, x2, x3, x4, x5, x6, x7;
+    uint8_t y1, y2, y3, y4, y5, y6, y7, y8, y9, y10, y11, y12, y13, y14, y15;
+    uint8_t y16, y17, y18, y19, y20, y21;
+    uint8_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9, z10, z11, z12, z13, z14, z15, z16, z17;
+    uint8_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15;
+    uint8_t t16, t17, t18, t19, t20, t21, t22, t23, t24, t25, t26, t27, t28, t29, t30, t31;
+    uint8_t t32, t33, t34, t35, t36, t37, t38, t39, t40, t41, t42, t43, t44, t45, t46, t47;
+    uint8_t t48, t49, t50, t51, t52, t53, t54, t55, t56, t57, t58, t59, t60, t61, t62, t63;
+    uint8_t t64, t65, t66, t67;
+    uint8_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+    x0 = q[7];
+    x1 = q[6];
+    x2 = q[5];
+    x3 = q[4];
+    x4 = q[3];
+    x5 = q[2];
+    x6 = q[1];
+    x7 = q[0];
+
+    y14 = x3 ^ x5;
+    y13 = x0 ^ x6;
+    y9 = x0 ^ x3;
+    y8 = x0 ^ x5;
+    t0 = x1 ^ x2;
+    y1 = t0 ^ x7;
+    y4 = y1 ^ x3;
+    y12 = y13 ^ y14;
+    y2 = y1 ^ x0;
+    y5 = y1 ^ x6;
+    y3 = y5 ^ y8;
+    t1 = x4 ^ y12;
+    y15 = t1 ^ x5;
+    y20 = t1 ^ x1;
+    y6 = y15 ^ x7;
+    y10 = y15 ^ t0;
+    y11 = y20 ^ y9;
+    y7 = x7 ^ y11;
+    y17 = y10 ^ y11;
+    y19 = y10 ^ y8;
+    y16 = t0 ^ y11;
+    y21 = y13 ^ y16;
+    y18 = x0 ^ y16;
+    t2 = y12 & y15;
+    t3 = y3 & y6;
+    t4 = t3 ^ t2;
+    t5 = y4 & x7;
+    t6 = t5 ^ t2;
+    t7 = y13 & y16;
+    t8 = y5 & y1;
+    t9 = t8 ^ t7;
+    t10 = y2 & y7;
+    t11 = t10 ^ t7;
+    t12 = y9 & y11;
+    t13 = y14 & y17;
+    t14 = t13 ^ t12;
+    t15 = y8 & y10;
+    t16 = t15 ^ t12;
+    t17 = t4 ^ t14;
+    t18 = t6 ^ t16;
+    t19 = t9 ^ t14;
+    t20 = t11 ^ t16;
+    t21 = t17 ^ y20;
+    t22 = t18 ^ y19;
+    t23 = t19 ^ y21;
+    t24 = t20 ^ y18;
+    t25 = t21 ^ t22;
+    t26 = t21 & t23;
+    t27 = t24 ^ t26;
+    t28 = t25 & t27;
+    t29 = t28 ^ t22;
+    t30 = t23 ^ t24;
+    t31 = t22 ^ t26;
+    t32 = t31 & t30;
+    t33 = t32 ^ t24;
+    t34 = t23 ^ t33;
+    t35 = t27 ^ t33;
+    t36 = t24 & t35;
+    t37 = t36 ^ t34;
+    t38 = t27 ^ t36;
+    t39 = t29 & t38;
+    t40 = t25 ^ t39;
+    t41 = t40 ^ t37;
+    t42 = t29 ^ t33;
+    t43 = t29 ^ t40;
+    t44 = t33 ^ t37;
+    t45 = t42 ^ t41;
+    z0 = t44 & y15;
+    z1 = t37 & y6;
+    z2 = t33 & x7;
+    z3 = t43 & y16;
+    z4 = t40 & y1;
+    z5 = t29 & y7;
+    z6 = t42 & y11;
+    z7 = t45 & y17;
+    z8 = t41 & y10;
+    z9 = t44 & y12;
+    z10 = t37 & y3;
+    z11 = t33 & y4;
+    z12 = t43 & y13;
+    z13 = t40 & y5;
+    z14 = t29 & y2;
+    z15 = t42 & y9;
+    z16 = t45 & y14;
+    z17 = t41 & y8;
+    t46 = z15 ^ z16;
+    t47 = z10 ^ z11;
+    t48 = z5 ^ z13;
+    t49 = z9 ^ z10;
+    t50 = z2 ^ z12;
+    t51 = z2 ^ z5;
+    t52 = z7 ^ z8;
+    t53 = z0 ^ z3;
+    t54 = z6 ^ z7;
+    t55 = z16 ^ z17;
+    t56 = z12 ^ t48;
+    t57 = t50 ^ t53;
+    t58 = z4 ^ t46;
+    t59 = z3 ^ t54;
+    t60 = t46 ^ t57;
+    t61 = z14 ^ t57;
+    t62 = t52 ^ t58;
+    t63 = t49 ^ t58;
+    t64 = z4 ^ t59;
+    t65 = t61 ^ t62;
+    t66 = z1 ^ t63;
+    s0 = t59 ^ t63;
+    s6 = t56 ^ (uint8_t)~t62;
+    s7 = t48 ^ (uint8_t)~t60;
+    t67 = t64 ^ t65;
+    s3 = t53 ^ t66;
+    s4 = t51 ^ t66;
+    s5 = t47 ^ t65;
+    s1 = t64 ^ (uint8_t)~s3;
+    s2 = t55 ^ (uint8_t)~t67;
+
+    q[7] = s0;
+    q[6] = s1;
+    q[5] = s2;
+    q[4] = s3;
+    q[3] = s4;
+    q[2] = s5;
+    q[1] = s6;
+    q[0] = s7;
+}
+
+/*
+ * Bit k of s[j] goes to bit j of q[k]. An 8x8 bit matrix transposes back the
+ * same way, so this both packs and unpacks. Shifting in from the top avoids
+ * the variable shifts AVR does in a loop.
+ */
+static void gf_transpose(uint8_t *q, const uint8_t *s) {
+
+    uint8_t b, j, k;
+
+    for (k = 0; k < 8; ++k) {
+        q[k] = 0;
+    }
+    for (j = 0; j < 8; ++j) {
+        b = s[j];
+        for (k = 0; k < 8; ++k) {
+            q[k] = (uint8_t)((q[k] >> 1) | (b << 7));
+            b >>= 1;
+        }
+    }
+}
+
+/*
+ * L^-1(y) = y <<< 1 ^ y <<< 3 ^ y <<< 6, and ^ 63 flips planes 0, 1, 5 and 6
+ */
+static void gf_inv_affine_planes(uint8_t *q) {
+
+    uint8_t y[8];
+    uint8_t k;
+
+    for (k = 0; k < 8; ++k) {
+        y[k] = q[k];
+    }
+    for (k = 0; k < 8; ++k) {
+        q[k] = y[(k + 7) & 7] ^ y[(k + 5) & 7] ^ y[(k + 2) & 7];
+    }
+}
+
+static void gf_flip63_planes(uint8_t *q) {
+    q[0] = ~q[0];
+    q[1] = ~q[1];
+    q[5] = ~q[5];
+    q[6] = ~q[6];
+}
+
+static void gf_sub_bytes(uint8_t *s, uint8_t n, uint8_t inverse) {
+
+    uint8_t b[8], q[8];
+    uint8_t i, m;
+
+    while (n > 0) {
+        m = n < 8 ? n : 8;
+        for (i = 0; i < 8; ++i) {
+            b[i] = i < m ? s[i] : 0;
+        }
+        gf_transpose(q, b);
+        if (inverse) {
+            gf_flip63_planes(q);
+            gf_inv_affine_planes(q);
+            gf_sbox_planes(q);
+            gf_flip63_planes(q);
+            gf_inv_affine_planes(q);
+        } else {
+            gf_sbox_planes(q);
+        }
+        gf_transpose(b, q);
+        for (i = 0; i < m; ++i) {
+            s[i] = b[i];
+        }
+        s += m;
+        n -= m;
+    }
+}
+
+void aes_gf_sub_bytes(uint8_t *s, uint8_t n) {
+    gf_sub_bytes(s, n, 0);
+}
+
+void aes_gf_inv_sub_bytes(uint8_t *s, uint8_t n) {
+    gf_sub_bytes(s, n, 1);
+}
+
+void aes_gf128_double(const uint8_t *in, uint8_t *out) {
+
+    uint8_t carry = in[0] >> 7;
+    uint8_t i;
+
+    for (i = 0; i < 15; ++i) {
+        out[i] = (uint8_t)((in[i] << 1) | (in[i+1] >> 7));
+    }
+    out[15] = (uint8_t)((in[15] << 1) ^ (-carry & 0x87));
+}
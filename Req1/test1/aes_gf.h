@@ -0,0 +1,109 @@
+/*
+ * aes_gf.h
+ *
+ * GF(2^8) arithmetic shared by the ciphers and the key schedule, modulo
+ * x^8 + x^4 + x^3 + x + 1. Everything here is branchless and free of
+ * table lookups, so its timing does not depend on the operands.
+ * The small helpers are inline, the rest is in aes_gf.c.
+ *
+ */
+#ifndef AES_GF_H
+#define AES_GF_H
+#include <stdint.h>
+
+/**
+ * @purpose:    Multiply by 02 (xtime). The reduction is masked in from bit 7
+ *              instead of branching on it.
+ */
+static inline uint8_t gf_xtime(uint8_t a) {
+    return (uint8_t)((a << 1) ^ (-(a >> 7) & 0x1b));
+}
+
+/**
+ * @purpose:    InvMixColumns on one column, in and out may be the same. The column is
+ *              pre-multiplied by [05 00 04 00] (circulant) and then mixed with MixColumns,
+ *              whose product is InvMixColumns.
+ */
+static inline void gf_inv_mix_column(uint8_t *out, const uint8_t *in) {
+
+    uint8_t a0 = in[0], a1 = in[1], a2 = in[2], a3 = in[3];
+    uint8_t t, u, v;
+
+    u = gf_xtime(gf_xtime(a0 ^ a2));
+    v = gf_xtime(gf_xtime(a1 ^ a3));
+    a0 ^= u;
+    a1 ^= v;
+    a2 ^= u;
+    a3 ^= v;
+    t = a0 ^ a1 ^ a2 ^ a3;
+    out[0] = gf_xtime(a0 ^ a1) ^ a0 ^ t;
+    out[1] = gf_xtime(a1 ^ a2) ^ a1 ^ t;
+    out[2] = gf_xtime(a2 ^ a3) ^ a2 ^ t;
+    out[3] = gf_xtime(a3 ^ a0) ^ a3 ^ t;
+}
+
+/**
+ * @purpose:    xtime on the four bytes of a word at once (SWAR)
+ */
+static inline uint32_t gf_xtime_word(uint32_t w) {
+    return ((w & 0x7f7f7f7f) << 1) ^ (((w >> 7) & 0x01010101) * 0x1b);
+}
+
+/**
+ * @purpose:    Word-state helpers: a column is one uint32_t with row r in byte r, so that
+ *              the state loads and stores little-endian on any host.
+ */
+static inline uint32_t gf_load_word(const uint8_t *p) {
+    return (uint32_t)p[0] ^ ((uint32_t)p[1] << 8) ^ ((uint32_t)p[2] << 16) ^ ((uint32_t)p[3] << 24);
+}
+
+static inline void gf_store_word(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @purpose:    Rotate right, n in 1..31
+ */
+static inline uint32_t gf_rotr32(uint32_t v, uint8_t n) {
+    return (v >> n) | (v << (32 - n));
+}
+
+/**
+ * @purpose:    MixColumns on one column word, 02.t ^ rot8(w) ^ rot16(t) with t = w ^ rot8(w),
+ *              rot8 moving row r+1 to row r. Same algebra as the byte loop of aes_encrypt.c.
+ */
+static inline uint32_t gf_mix_column_word(uint32_t w) {
+    uint32_t r = gf_rotr32(w, 8);
+    uint32_t t = w ^ r;
+    return gf_xtime_word(t) ^ r ^ gf_rotr32(t, 16);
+}
+
+/**
+ * @purpose:            SubBytes without tables, in place, eight bytes per pass. The bytes are
+ *                      transposed into bit planes and run through the Boyar-Peralta circuit,
+ *                      which inverts in the tower field GF(((2^2)^2)^2) and applies the affine
+ *                      transform in 113 gates. Constant time.
+ * @par[in,out]s:       n bytes
+ */
+void aes_gf_sub_bytes(uint8_t *s, uint8_t n);
+
+/**
+ * @purpose:            InvSubBytes without tables, in place, as
+ *                      S^-1(y) = L^-1(S(L^-1(y ^ 63)) ^ 63) with L the linear part of the affine
+ *                      transform. Constant time.
+ * @par[in,out]s:       n bytes
+ */
+void aes_gf_inv_sub_bytes(uint8_t *s, uint8_t n);
+
+/**
+ * @purpose:            Doubling in GF(2^128) with the big-endian bit order of CMAC
+ *                      (subkey derivation, x^128 + x^7 + x^2 + x + 1), constant time.
+ *                      in and out may point to the same memory.
+ * @par[in]in:          16 bytes
+ * @par[out]out:        16 bytes, in.x
+ */
+void aes_gf128_double(const uint8_t *in, uint8_t *out);
+#endif
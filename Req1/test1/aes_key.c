@@ -0,0 +1,156 @@
+/*
+ * aes_key.c
+ *
+ * Key contexts, see aes_key.h.
+ *
+ */
+#include <stdint.h>
+#include <string.h>
+#include "aes_config.h"
+#include "aes_gf.h"
+#include "aes_key.h"
+#include "aes_schedule.h"
+#include "aes_encrypt.h"
+#include "aes_decrypt.h"
+#include "aes_ttable.h"
+
+/*
+ * Reduction of the four bits shifted out at the bottom of Z, as the
+ * top 16 bits of the high half (multiples of 0xe1 in GCM bit order)
+ */
+static const uint16_t GHASH_LAST4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+static uint64_t load_be64(const uint8_t *p) {
+
+    uint64_t v = 0;
+    uint8_t i;
+
+    for (i = 0; i < 8; ++i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static void store_be64(uint8_t *p, uint64_t v) {
+
+    uint8_t i;
+
+    for (i = 8; i > 0; --i) {
+        p[i-1] = (uint8_t)v;
+        v >>= 8;
+    }
+}
+
+/*
+ * In GCM order bit 0 is the top bit of byte 0, so multiplying by x is a
+ * right shift. Entry 8 is H, entries 4, 2 and 1 are H.x, H.x^2 and H.x^3,
+ * and the others are sums of those.
+ */
+static void ghash_table(aes_key_ctx *ctx) {
+
+    uint64_t vh, vl, t;
+    uint8_t i, j;
+
+    vh = load_be64(ctx->ghash_h);
+    vl = load_be64(ctx->ghash_h + 8);
+    ctx->ghash_hh[0] = 0;
+    ctx->ghash_hl[0] = 0;
+    ctx->ghash_hh[8] = vh;
+    ctx->ghash_hl[8] = vl;
+    for (i = 4; i > 0; i >>= 1) {
+        t = (vl & 1) * 0xe100000000000000ULL;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ t;
+        ctx->ghash_hh[i] = vh;
+        ctx->ghash_hl[i] = vl;
+    }
+    for (i = 2; i <= 8; i <<= 1) {
+        for (j = 1; j < i; ++j) {
+            ctx->ghash_hh[i+j] = ctx->ghash_hh[i] ^ ctx->ghash_hh[j];
+            ctx->ghash_hl[i+j] = ctx->ghash_hl[i] ^ ctx->ghash_hl[j];
+        }
+    }
+}
+
+void aes_key_ctx_init(aes_key_ctx *ctx, const uint8_t *key) {
+
+    uint8_t zero[AES_BLOCK_SIZE];
+    uint8_t i;
+
+    aes_key_schedule_128(key, ctx->enc);
+    aes_key_schedule_128_dec(key, ctx->dec);
+
+    // GCM's H and CMAC's L are the same block, E_K(0^128)
+    for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+        zero[i] = 0;
+    }
+    aes_encrypt_128(ctx->enc, zero, ctx->ghash_h);
+    ghash_table(ctx);
+    aes_gf128_double(ctx->ghash_h, ctx->cmac_k1);
+    aes_gf128_double(ctx->cmac_k1, ctx->cmac_k2);
+#if AES_ENGINE == AES_ENGINE_AUTO && AES_HAVE_SSE2
+    aes_bs_key_schedule_128(ctx->enc, ctx->bs);
+#endif
+}
+
+/*
+ * With GCC a memset that the empty asm claims to read, so it is not dropped
+ * as a dead store. The volatile byte loop is ten times slower on the host.
+ */
+void aes_key_wipe(void *p, size_t n) {
+#if defined(__GNUC__)
+    memset(p, 0, n);
+    __asm__ __volatile__("" : : "r"(p) : "memory");
+#else
+    volatile uint8_t *v = p;
+
+    while (n-- > 0) {
+        *v++ = 0;
+    }
+#endif
+}
+
+void aes_key_ctx_clear(aes_key_ctx *ctx) {
+    aes_key_wipe(ctx, sizeof(aes_key_ctx));
+}
+
+void aes_key_ctx_encrypt(const aes_key_ctx *ctx, uint8_t *plaintext, uint8_t *ciphertext) {
+    aes_encrypt_128((uint8_t *)ctx->enc, plaintext, ciphertext);
+}
+
+void aes_key_ctx_decrypt(const aes_key_ctx *ctx, uint8_t *ciphertext, uint8_t *plaintext) {
+#if AES_ENGINE == AES_ENGINE_TTABLE
+    aes_decrypt_128_ttable((uint8_t *)ctx->dec, ciphertext, plaintext);
+#else
+    aes_decrypt_128((uint8_t *)ctx->enc, ciphertext, plaintext);
+#endif
+}
+
+/*
+ * Shoup's 4-bit method: Horner's rule over the nibbles of X from the last
+ * one, shifting Z by x^4 and folding the bits that fall off back in
+ */
+void aes_key_ctx_ghash_mul(const aes_key_ctx *ctx, uint8_t *x) {
+
+    uint64_t zh, zl;
+    uint8_t i, n, rem;
+
+    zh = 0;
+    zl = 0;
+    for (i = 2*AES_BLOCK_SIZE; i > 0; --i) {
+        n = x[(i-1) >> 1];
+        n = (i & 1) ? n >> 4 : n & 0x0f;
+        if (i < 2*AES_BLOCK_SIZE) {
+            rem = (uint8_t)(zl & 0x0f);
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ ((uint64_t)GHASH_LAST4[rem] << 48);
+        }
+        zh ^= ctx->ghash_hh[n];
+        zl ^= ctx->ghash_hl[n];
+    }
+    store_be64(x, zh);
+    store_be64(x + 8, zl);
+}
@@ -0,0 +1,63 @@
+/*
+ * aes_key.h
+ *
+ * Expanded AES-128 key with everything derived from it: the encryption and
+ * decryption schedules and the subkeys of the GCM and CMAC modes. Set up once
+ * per key with aes_key_ctx_init, after that no call on the context touches the
+ * key schedule again.
+ *
+ */
+#ifndef AES_KEY_H
+#define AES_KEY_H
+#include <stddef.h>
+#include <stdint.h>
+#include "aes_config.h"
+#include "aes_schedule.h"
+#include "aes_bitslice.h"
+
+typedef struct aes_key_ctx {
+    uint8_t  enc[AES_ROUND_KEY_SIZE] AES_ALIGN(16);     // aes_key_schedule_128
+    uint8_t  dec[AES_ROUND_KEY_SIZE] AES_ALIGN(16);     // aes_key_schedule_128_dec, for the equivalent inverse cipher
+    uint64_t ghash_hh[16];                              // i.H for every 4-bit i, high and low halves (Shoup's table)
+    uint64_t ghash_hl[16];
+    uint8_t  ghash_h[AES_BLOCK_SIZE];                   // H = E_K(0^128)
+    uint8_t  cmac_k1[AES_BLOCK_SIZE];                   // L.x and L.x^2 with L = E_K(0^128)
+    uint8_t  cmac_k2[AES_BLOCK_SIZE];
+#if AES_ENGINE == AES_ENGINE_AUTO && AES_HAVE_SSE2
+    uint8_t  bs[AES_BS_ROUND_KEY_SIZE] AES_ALIGN(16);   // aes_bs_key_schedule_128 of enc, for the bitsliced bulk path
+#endif
+} aes_key_ctx;
+
+/**
+ * @purpose:            Expand a key into ctx: both schedules, the GHASH table, the CMAC subkeys
+ *                      and, in AES_ENGINE_AUTO builds with SSE2, the bitsliced round keys.
+ * @par[out]ctx:        context to fill
+ * @par[in]key:         16 bytes of master keys
+ */
+void aes_key_ctx_init(aes_key_ctx *ctx, const uint8_t *key);
+
+/**
+ * @purpose:            Overwrite the whole context with zeros, in a way the compiler cannot drop.
+ */
+void aes_key_ctx_clear(aes_key_ctx *ctx);
+
+/**
+ * @purpose:            Overwrite n bytes of key material with zeros, the same way
+ */
+void aes_key_wipe(void *p, size_t n);
+
+/**
+ * @purpose:            One block with the schedules of ctx, through the configured engine.
+ *                      Decryption uses the T-table engine on ctx->dec when AES_ENGINE selects it.
+ */
+void aes_key_ctx_encrypt(const aes_key_ctx *ctx, uint8_t *plaintext, uint8_t *ciphertext);
+void aes_key_ctx_decrypt(const aes_key_ctx *ctx, uint8_t *ciphertext, uint8_t *plaintext);
+
+/**
+ * @purpose:            GHASH multiplication X = X.H in GF(2^128) with the bit order of GCM,
+ *                      four bits per step from the table in ctx. The table lookups depend
+ *                      on X, like those of the T-table engine.
+ * @par[in,out]x:       16 bytes
+ */
+void aes_key_ctx_ghash_mul(const aes_key_ctx *ctx, uint8_t *x);
+#endif
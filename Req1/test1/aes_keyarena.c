@@ -0,0 +1,171 @@
+/*
+ * aes_keyarena.c
+ *
+ * Slab allocator for key contexts, see aes_keyarena.h. Built empty without
+ * mmap and POSIX threads, like the key cache.
+ *
+ */
+#include <stdint.h>
+#include "aes_config.h"
+
+#if AES_HAVE_MMAP && AES_HAVE_PTHREAD
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "aes_key.h"
+#include "aes_keyarena.h"
+
+#define ARENA_SLAB      65536
+#define ARENA_LINE      64
+#define ARENA_SLOT      ((sizeof(aes_key_ctx) + ARENA_LINE - 1) & ~(size_t)(ARENA_LINE - 1))
+#define ARENA_PER_SLAB  ((ARENA_SLAB - ARENA_LINE) / ARENA_SLOT)
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS   MAP_ANON
+#endif
+
+/*
+ * The first cache line of every slab links it to the next one, the
+ * contexts follow on line boundaries
+ */
+typedef struct arena_slab {
+    struct arena_slab *next;
+    uint8_t locked;
+} arena_slab;
+
+// a released context holds only this link, everything else is zero
+typedef struct arena_free {
+    struct arena_free *next;
+} arena_free;
+
+struct aes_key_arena {
+    pthread_mutex_t lock;
+    arena_slab *slabs;
+    arena_free *free;
+    uint32_t live;
+    uint32_t max_contexts;
+    uint32_t flags;
+    uint64_t mapped;
+    uint64_t locked;
+};
+
+/*
+ * Map, lock and thread a new slab onto the free list, arena lock held.
+ * Fresh anonymous pages are zero, so the contexts need no clearing.
+ */
+static int arena_grow(aes_key_arena *arena) {
+
+    arena_slab *slab;
+    arena_free *f;
+    uint8_t *p;
+    size_t i;
+
+    p = mmap(NULL, ARENA_SLAB, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return -1;
+    }
+    slab = (arena_slab *)p;
+    slab->locked = mlock(p, ARENA_SLAB) == 0;
+    if (!slab->locked && (arena->flags & AES_KEY_ARENA_MUST_LOCK)) {
+        munmap(p, ARENA_SLAB);
+        return -1;
+    }
+#if defined(MADV_DONTDUMP)
+    // keep round keys out of core dumps too
+    madvise(p, ARENA_SLAB, MADV_DONTDUMP);
+#endif
+    slab->next = arena->slabs;
+    arena->slabs = slab;
+    arena->mapped += ARENA_SLAB;
+    arena->locked += slab->locked ? ARENA_SLAB : 0;
+
+    // last slot first, so allocations walk the slab upwards
+    for (i = ARENA_PER_SLAB; i > 0; --i) {
+        f = (arena_free *)(p + ARENA_LINE + (i - 1) * ARENA_SLOT);
+        f->next = arena->free;
+        arena->free = f;
+    }
+    return 0;
+}
+
+aes_key_arena *aes_key_arena_create(uint32_t max_contexts, uint32_t flags) {
+
+    aes_key_arena *arena;
+
+    arena = calloc(1, sizeof(aes_key_arena));
+    if (arena == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&arena->lock, NULL);
+    arena->max_contexts = max_contexts;
+    arena->flags = flags;
+    return arena;
+}
+
+void aes_key_arena_destroy(aes_key_arena *arena) {
+
+    arena_slab *slab, *next;
+
+    if (arena == NULL) {
+        return;
+    }
+    for (slab = arena->slabs; slab != NULL; slab = next) {
+        next = slab->next;
+        aes_key_wipe(slab, ARENA_SLAB);
+        munlock(slab, ARENA_SLAB);
+        munmap(slab, ARENA_SLAB);
+    }
+    pthread_mutex_destroy(&arena->lock);
+    free(arena);
+}
+
+aes_key_ctx *aes_key_arena_alloc(aes_key_arena *arena) {
+
+    arena_free *f = NULL;
+
+    pthread_mutex_lock(&arena->lock);
+    if (arena->max_contexts == 0 || arena->live < arena->max_contexts) {
+        if (arena->free != NULL || arena_grow(arena) == 0) {
+            f = arena->free;
+            arena->free = f->next;
+            ++arena->live;
+        }
+    }
+    pthread_mutex_unlock(&arena->lock);
+    if (f != NULL) {
+        f->next = NULL;
+    }
+    return (aes_key_ctx *)f;
+}
+
+void aes_key_arena_free(aes_key_arena *arena, aes_key_ctx *ctx) {
+
+    arena_free *f = (arena_free *)ctx;
+
+    if (ctx == NULL) {
+        return;
+    }
+    // outside the lock, the context is still owned by the caller
+    aes_key_ctx_clear(ctx);
+    pthread_mutex_lock(&arena->lock);
+    f->next = arena->free;
+    arena->free = f;
+    --arena->live;
+    pthread_mutex_unlock(&arena->lock);
+}
+
+void aes_key_arena_stats(aes_key_arena *arena, uint32_t *live, uint64_t *mapped, uint64_t *locked) {
+    pthread_mutex_lock(&arena->lock);
+    if (live != NULL) {
+        *live = arena->live;
+    }
+    if (mapped != NULL) {
+        *mapped = arena->mapped;
+    }
+    if (locked != NULL) {
+        *locked = arena->locked;
+    }
+    pthread_mutex_unlock(&arena->lock);
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * aes_keyarena.h
+ *
+ * Slab allocator for key contexts. Contexts come from 64 KB slabs mapped
+ * straight from the kernel and locked into RAM, so round keys never reach
+ * swap, each context starts on a cache line of its own, and allocating or
+ * releasing one is a free-list push or pop under the arena lock. Released
+ * contexts are zeroized before they go back on the list. Host builds only
+ * (AES_HAVE_MMAP and AES_HAVE_PTHREAD).
+ *
+ */
+#ifndef AES_KEYARENA_H
+#define AES_KEYARENA_H
+#include <stdint.h>
+#include "aes_config.h"
+#include "aes_key.h"
+
+#if AES_HAVE_MMAP && AES_HAVE_PTHREAD
+
+#define AES_KEY_ARENA_MUST_LOCK     0x01    // fail instead of handing out memory mlock refused
+
+typedef struct aes_key_arena aes_key_arena;
+
+/**
+ * @purpose:            Create an empty arena. Slabs are mapped on demand and kept until
+ *                      aes_key_arena_destroy.
+ * @par[in]max_contexts: upper bound on live contexts, 0 for no bound
+ * @par[in]flags:       0 or AES_KEY_ARENA_MUST_LOCK. Without it a slab that cannot be locked
+ *                      (RLIMIT_MEMLOCK) is used anyway and only left out of the locked count.
+ * @return:             the arena, or NULL if out of memory
+ */
+aes_key_arena *aes_key_arena_create(uint32_t max_contexts, uint32_t flags);
+
+/**
+ * @purpose:            Zeroize, unlock and unmap every slab. Contexts still allocated become invalid.
+ */
+void aes_key_arena_destroy(aes_key_arena *arena);
+
+/**
+ * @purpose:            Allocate a zeroed, 64-byte aligned context, e.g. for aes_key_ctx_init.
+ * @return:             the context, or NULL if the bound is reached, no slab can be mapped, or
+ *                      a new slab cannot be locked under AES_KEY_ARENA_MUST_LOCK
+ */
+aes_key_ctx *aes_key_arena_alloc(aes_key_arena *arena);
+
+/**
+ * @purpose:            Zeroize a context and return it to the arena it came from. NULL is ignored.
+ */
+void aes_key_arena_free(aes_key_arena *arena, aes_key_ctx *ctx);
+
+/**
+ * @purpose:            Live contexts, and bytes mapped and locked by the arena. Any pointer may be NULL.
+ */
+void aes_key_arena_stats(aes_key_arena *arena, uint32_t *live, uint64_t *mapped, uint64_t *locked);
+
+#endif
+#endif
@@ -0,0 +1,347 @@
+/*
+ * aes_keycache.c
+ *
+ * Sharded LRU cache of key contexts, see aes_keycache.h. Built empty without
+ * POSIX threads, so the AVR project does not pull in malloc.
+ *
+ */
+#include <stdint.h>
+#include "aes_config.h"
+
+#if AES_HAVE_PTHREAD
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "aes_key.h"
+#include "aes_keycache.h"
+
+#define KEYCACHE_SHARDS     16  // default, enough to keep a few dozen threads off each other's locks
+
+typedef struct key_entry {
+    aes_key_ctx ctx;                // first, so it gets the alignment of the entry array
+    uint64_t id;
+    struct key_entry *hnext;        // hash chain
+    struct key_entry *prev;         // LRU list, most recently used at the head
+    struct key_entry *next;         // also chains the free entries
+} key_entry;
+
+/*
+ * Each shard on its own cache lines, so that taking one lock does not
+ * bounce the line of the next shard between cores
+ */
+typedef struct key_shard {
+    pthread_mutex_t lock;
+    key_entry **buckets;
+    uint32_t mask;                  // number of buckets - 1
+    key_entry *head;
+    key_entry *tail;
+    key_entry *free;
+    uint64_t gen;                   // bumped by put and remove, see aes_key_cache_get
+    uint64_t hits;
+    uint64_t misses;
+} AES_ALIGN(64) key_shard;
+
+struct aes_key_cache {
+    key_shard *shards;
+    uint32_t shard_mask;
+    uint32_t nentries;
+    key_entry *entries;
+    aes_key_loader loader;
+    void *arg;
+};
+
+// murmur3 finalizer, ids are often sequential
+static uint64_t key_hash(uint64_t id) {
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdULL;
+    id ^= id >> 33;
+    id *= 0xc4ceb9fe1a85ec53ULL;
+    id ^= id >> 33;
+    return id;
+}
+
+// 0 if n is above the largest power of two that fits
+static uint32_t pow2_at_least(uint32_t n) {
+
+    uint32_t p = 1;
+
+    if (n > 0x80000000u) {
+        return 0;
+    }
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+// the shard takes the high half of the hash, the bucket the low half
+static key_shard *shard_of(aes_key_cache *cache, uint64_t h) {
+    return &cache->shards[(uint32_t)(h >> 32) & cache->shard_mask];
+}
+
+static key_entry *shard_find(key_shard *shard, uint64_t id, uint64_t h) {
+
+    key_entry *e;
+
+    for (e = shard->buckets[h & shard->mask]; e != NULL; e = e->hnext) {
+        if (e->id == id) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void lru_unlink(key_shard *shard, key_entry *e) {
+    if (e->prev != NULL) {
+        e->prev->next = e->next;
+    } else {
+        shard->head = e->next;
+    }
+    if (e->next != NULL) {
+        e->next->prev = e->prev;
+    } else {
+        shard->tail = e->prev;
+    }
+}
+
+static void lru_push(key_shard *shard, key_entry *e) {
+    e->prev = NULL;
+    e->next = shard->head;
+    if (shard->head != NULL) {
+        shard->head->prev = e;
+    } else {
+        shard->tail = e;
+    }
+    shard->head = e;
+}
+
+static void hash_unlink(key_shard *shard, key_entry *e) {
+
+    key_entry **p = &shard->buckets[key_hash(e->id) & shard->mask];
+
+    while (*p != e) {
+        p = &(*p)->hnext;
+    }
+    *p = e->hnext;
+}
+
+/*
+ * Store ctx under id, reusing the entry of id, a free one or the least
+ * recently used one, in that order. Called with the shard lock held.
+ */
+static void shard_insert(key_shard *shard, uint64_t id, uint64_t h, const aes_key_ctx *ctx) {
+
+    key_entry *e;
+
+    e = shard_find(shard, id, h);
+    if (e != NULL) {
+        lru_unlink(shard, e);
+    } else {
+        if (shard->free != NULL) {
+            e = shard->free;
+            shard->free = e->next;
+        } else {
+            e = shard->tail;
+            lru_unlink(shard, e);
+            hash_unlink(shard, e);
+        }
+        e->id = id;
+        e->hnext = shard->buckets[h & shard->mask];
+        shard->buckets[h & shard->mask] = e;
+    }
+    memcpy(&e->ctx, ctx, sizeof(aes_key_ctx));
+    lru_push(shard, e);
+}
+
+static void cache_free(aes_key_cache *cache) {
+
+    uint32_t i;
+
+    for (i = 0; i <= cache->shard_mask; ++i) {
+        free(cache->shards[i].buckets);
+    }
+    free(cache->entries);
+    free(cache->shards);
+    free(cache);
+}
+
+aes_key_cache *aes_key_cache_create(uint32_t capacity, uint32_t shards, aes_key_loader loader, void *arg) {
+
+    aes_key_cache *cache;
+    key_shard *shard;
+    void *mem;
+    uint32_t per_shard, nbuckets, i, j;
+
+    shards = pow2_at_least(shards == 0 ? KEYCACHE_SHARDS : shards);
+    if (shards == 0) {
+        return NULL;
+    }
+    per_shard = capacity / shards + (capacity % shards != 0);
+    if (per_shard == 0) {
+        per_shard = 1;
+    }
+    nbuckets = pow2_at_least(per_shard);
+    // the entry count has to fit 32 bits as well
+    if (nbuckets == 0 || per_shard > UINT32_MAX / shards) {
+        return NULL;
+    }
+
+    cache = calloc(1, sizeof(aes_key_cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->shard_mask = shards - 1;
+    cache->nentries = shards * per_shard;
+    cache->loader = loader;
+    cache->arg = arg;
+    if (posix_memalign(&mem, 64, shards * sizeof(key_shard)) != 0) {
+        free(cache);
+        return NULL;
+    }
+    cache->shards = mem;
+    memset(cache->shards, 0, shards * sizeof(key_shard));
+    if (posix_memalign(&mem, 64, (size_t)cache->nentries * sizeof(key_entry)) != 0) {
+        free(cache->shards);
+        free(cache);
+        return NULL;
+    }
+    cache->entries = mem;
+    memset(cache->entries, 0, (size_t)cache->nentries * sizeof(key_entry));
+
+    for (i = 0; i < shards; ++i) {
+        cache->shards[i].buckets = calloc(nbuckets, sizeof(key_entry *));
+        if (cache->shards[i].buckets == NULL) {
+            cache_free(cache);
+            return NULL;
+        }
+    }
+    for (i = 0; i < shards; ++i) {
+        shard = &cache->shards[i];
+        shard->mask = nbuckets - 1;
+        pthread_mutex_init(&shard->lock, NULL);
+        for (j = 0; j < per_shard; ++j) {
+            cache->entries[i*per_shard + j].next = shard->free;
+            shard->free = &cache->entries[i*per_shard + j];
+        }
+    }
+    return cache;
+}
+
+void aes_key_cache_destroy(aes_key_cache *cache) {
+
+    uint32_t i;
+
+    if (cache == NULL) {
+        return;
+    }
+    for (i = 0; i < cache->nentries; ++i) {
+        aes_key_ctx_clear(&cache->entries[i].ctx);
+    }
+    for (i = 0; i <= cache->shard_mask; ++i) {
+        pthread_mutex_destroy(&cache->shards[i].lock);
+    }
+    cache_free(cache);
+}
+
+int aes_key_cache_get(aes_key_cache *cache, uint64_t key_id, aes_key_ctx *ctx) {
+
+    uint64_t h = key_hash(key_id);
+    key_shard *shard = shard_of(cache, h);
+    key_entry *e;
+    uint8_t key[AES_BLOCK_SIZE];
+    uint64_t gen;
+    int found;
+
+    pthread_mutex_lock(&shard->lock);
+    e = shard_find(shard, key_id, h);
+    if (e != NULL) {
+        ++shard->hits;
+        lru_unlink(shard, e);
+        lru_push(shard, e);
+        memcpy(ctx, &e->ctx, sizeof(aes_key_ctx));
+    } else {
+        ++shard->misses;
+    }
+    gen = shard->gen;
+    pthread_mutex_unlock(&shard->lock);
+    if (e != NULL) {
+        return 0;
+    }
+
+    if (cache->loader == NULL) {
+        return -1;
+    }
+    found = cache->loader(key_id, key, cache->arg) == 0;
+    if (found) {
+        aes_key_ctx_init(ctx, key);
+        /*
+         * The loader ran unlocked. A put or remove since the lookup may have
+         * rekeyed or revoked the id, and caching what was loaded would bring
+         * the old key back, so the result is only cached if the shard saw
+         * neither and no other miss of the same id got there first.
+         */
+        pthread_mutex_lock(&shard->lock);
+        if (shard->gen == gen && shard_find(shard, key_id, h) == NULL) {
+            shard_insert(shard, key_id, h, ctx);
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    aes_key_wipe(key, sizeof(key));
+    return found ? 1 : -1;
+}
+
+void aes_key_cache_put(aes_key_cache *cache, uint64_t key_id, const uint8_t *key) {
+
+    uint64_t h = key_hash(key_id);
+    key_shard *shard = shard_of(cache, h);
+    aes_key_ctx ctx;
+
+    aes_key_ctx_init(&ctx, key);
+    pthread_mutex_lock(&shard->lock);
+    ++shard->gen;
+    shard_insert(shard, key_id, h, &ctx);
+    pthread_mutex_unlock(&shard->lock);
+    aes_key_ctx_clear(&ctx);
+}
+
+int aes_key_cache_remove(aes_key_cache *cache, uint64_t key_id) {
+
+    uint64_t h = key_hash(key_id);
+    key_shard *shard = shard_of(cache, h);
+    key_entry *e;
+
+    pthread_mutex_lock(&shard->lock);
+    // also when id is not cached: a miss may be loading it right now
+    ++shard->gen;
+    e = shard_find(shard, key_id, h);
+    if (e != NULL) {
+        lru_unlink(shard, e);
+        hash_unlink(shard, e);
+        aes_key_ctx_clear(&e->ctx);
+        e->next = shard->free;
+        shard->free = e;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return e != NULL ? 0 : -1;
+}
+
+void aes_key_cache_stats(aes_key_cache *cache, uint64_t *hits, uint64_t *misses) {
+
+    uint64_t h = 0, m = 0;
+    uint32_t i;
+
+    for (i = 0; i <= cache->shard_mask; ++i) {
+        pthread_mutex_lock(&cache->shards[i].lock);
+        h += cache->shards[i].hits;
+        m += cache->shards[i].misses;
+        pthread_mutex_unlock(&cache->shards[i].lock);
+    }
+    if (hits != NULL) {
+        *hits = h;
+    }
+    if (misses != NULL) {
+        *misses = m;
+    }
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * aes_keycache.h
+ *
+ * Bounded LRU cache of key contexts, indexed by a 64-bit key id, so that a
+ * key used by many requests is expanded once per process. The ids are spread
+ * over independent shards, each with its own lock, its own LRU list and a
+ * fixed share of the capacity, so threads working on different keys rarely
+ * meet. Host builds only (AES_HAVE_PTHREAD).
+ *
+ */
+#ifndef AES_KEYCACHE_H
+#define AES_KEYCACHE_H
+#include <stdint.h>
+#include "aes_config.h"
+#include "aes_key.h"
+
+#if AES_HAVE_PTHREAD
+
+typedef struct aes_key_cache aes_key_cache;
+
+/*
+ * Fetches the 16-byte key of key_id on a miss, e.g. from a key store.
+ * Returns 0 if found, anything else if the id is unknown. Called without
+ * any shard lock held.
+ */
+typedef int (*aes_key_loader)(uint64_t key_id, uint8_t *key, void *arg);
+
+/**
+ * @purpose:            Create a cache. All entries are allocated here, lookups and evictions
+ *                      do not allocate.
+ * @par[in]capacity:    number of contexts kept, split evenly over the shards (at least one each).
+ *                      Ids do not spread perfectly evenly, so leave some headroom over the
+ *                      working set, or the fullest shards start evicting hot keys.
+ * @par[in]shards:      number of shards, rounded up to a power of two, 0 picks a default
+ * @par[in]loader:      called on a miss, or NULL if keys only come in through aes_key_cache_put
+ * @par[in]arg:         passed to loader
+ * @return:             the cache, or NULL if out of memory or the sizes do not fit 32 bits
+ */
+aes_key_cache *aes_key_cache_create(uint32_t capacity, uint32_t shards, aes_key_loader loader, void *arg);
+
+/**
+ * @purpose:            Zeroize and free every context and the cache itself.
+ */
+void aes_key_cache_destroy(aes_key_cache *cache);
+
+/**
+ * @purpose:            Look a key up and copy its context out. On a miss the key comes from the
+ *                      loader, is expanded outside the lock and replaces the least recently
+ *                      used context of its shard, unless a put or remove in the same shard
+ *                      ran meanwhile: then the context is returned but not cached.
+ * @par[in]key_id:      key id
+ * @par[out]ctx:        the expanded key
+ * @return:             0 on a hit, 1 on a miss that was loaded, -1 if the key is unknown
+ */
+int aes_key_cache_get(aes_key_cache *cache, uint64_t key_id, aes_key_ctx *ctx);
+
+/**
+ * @purpose:            Expand a key and store it under key_id, replacing any context
+ *                      already cached for that id (rekeying).
+ * @par[in]key:         16 bytes of master keys
+ */
+void aes_key_cache_put(aes_key_cache *cache, uint64_t key_id, const uint8_t *key);
+
+/**
+ * @purpose:            Drop and zeroize the context of key_id, e.g. when the key is revoked.
+ * @return:             0 if it was cached, -1 otherwise
+ */
+int aes_key_cache_remove(aes_key_cache *cache, uint64_t key_id);
+
+/**
+ * @purpose:            Hit and miss counters summed over all shards. Either pointer may be NULL.
+ */
+void aes_key_cache_stats(aes_key_cache *cache, uint64_t *hits, uint64_t *misses);
+
+#endif
+#endif
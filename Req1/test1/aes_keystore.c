@@ -0,0 +1,320 @@
+/*
+ * aes_keystore.c
+ *
+ * Memory-mapped store of precomputed schedules, see aes_keystore.h for the
+ * file format. Built empty without mmap, so the AVR project does not pull in
+ * stdio.
+ *
+ */
+#include <stdint.h>
+#include "aes_config.h"
+
+#if AES_HAVE_MMAP
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "aes_key.h"
+#include "aes_schedule.h"
+#include "aes_keystore.h"
+
+#define KS_PAGE         4096
+#define KS_MAGIC        "AESKSTR"
+#define KS_BYTE_ORDER   0x01020304
+
+typedef struct ks_header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t byte_order;        // KS_BYTE_ORDER as the writer stored it
+    uint32_t page_size;
+    uint32_t record_size;
+    uint64_t nkeys;
+    uint64_t nslots;
+    uint64_t index_offset;
+    uint64_t records_offset;
+    uint64_t file_size;
+    uint64_t checksum;          // of everything above
+} ks_header;
+
+typedef struct ks_slot {
+    uint64_t key_id;
+    uint32_t record;            // record index + 1, 0 if the slot is empty
+    uint32_t reserved;
+} ks_slot;
+
+typedef struct ks_record {
+    uint8_t  enc[AES_ROUND_KEY_SIZE];
+    uint8_t  pad[16];           // zero, moves dec onto the next 64-byte boundary
+    uint8_t  dec[AES_ROUND_KEY_SIZE];
+    uint64_t key_id;
+    uint64_t checksum;          // of everything above
+} ks_record;
+
+// records stay on 64-byte boundaries and both schedules start on one
+typedef char ks_record_size_check[sizeof(ks_record) % 64 == 0 ? 1 : -1];
+typedef char ks_record_dec_check[offsetof(ks_record, dec) % 64 == 0 ? 1 : -1];
+
+// validation state of a record, kept in process memory next to the mapping
+#define KS_UNCHECKED    0
+#define KS_VALID        1
+#define KS_BAD          2
+
+struct aes_keystore {
+    uint8_t *map;
+    size_t size;
+    const ks_header *header;
+    const ks_slot *slots;
+    const ks_record *records;
+    uint8_t *state;
+};
+
+/*
+ * FNV-1a over 64-bit words. The sizes hashed here are multiples of 8 and the
+ * data is 8-byte aligned in the mapping.
+ */
+static uint64_t ks_checksum(const void *p, size_t n) {
+
+    const uint64_t *w = p;
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (n /= 8; n > 0; --n) {
+        h ^= *w++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// the same mix as the key cache, ids are often sequential
+static uint64_t ks_hash(uint64_t id) {
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdULL;
+    id ^= id >> 33;
+    id *= 0xc4ceb9fe1a85ec53ULL;
+    id ^= id >> 33;
+    return id;
+}
+
+static uint64_t ks_page_up(uint64_t n) {
+    return (n + KS_PAGE - 1) & ~(uint64_t)(KS_PAGE - 1);
+}
+
+int aes_keystore_build(const char *path, const uint64_t *key_ids, const uint8_t *keys, uint32_t nkeys) {
+
+    ks_header *header;
+    ks_slot *slots;
+    ks_record *records;
+    uint8_t *file, *roundkeys;
+    uint64_t nslots, size, i, s;
+    char *tmp;
+    FILE *f;
+    int ok;
+
+    nslots = 1;
+    while (nslots < 2 * (uint64_t)nkeys) {
+        nslots <<= 1;
+    }
+    size = KS_PAGE + ks_page_up(nslots * sizeof(ks_slot)) + ks_page_up((uint64_t)nkeys * sizeof(ks_record));
+    file = calloc(1, size);
+    roundkeys = malloc((size_t)nkeys * AES_ROUND_KEY_SIZE + 1);
+    tmp = malloc(strlen(path) + 24);
+    if (file == NULL || roundkeys == NULL || tmp == NULL) {
+        free(file);
+        free(roundkeys);
+        free(tmp);
+        return -1;
+    }
+
+    header = (ks_header *)file;
+    memcpy(header->magic, KS_MAGIC, sizeof(KS_MAGIC));
+    header->version = AES_KEYSTORE_VERSION;
+    header->byte_order = KS_BYTE_ORDER;
+    header->page_size = KS_PAGE;
+    header->record_size = sizeof(ks_record);
+    header->nkeys = nkeys;
+    header->nslots = nslots;
+    header->index_offset = KS_PAGE;
+    header->records_offset = KS_PAGE + ks_page_up(nslots * sizeof(ks_slot));
+    header->file_size = size;
+    header->checksum = ks_checksum(header, offsetof(ks_header, checksum));
+    slots = (ks_slot *)(file + header->index_offset);
+    records = (ks_record *)(file + header->records_offset);
+
+    aes_key_schedule_128_batch(keys, roundkeys, nkeys);
+    ok = 1;
+    for (i = 0; i < nkeys && ok; ++i) {
+        memcpy(records[i].enc, roundkeys + AES_ROUND_KEY_SIZE*i, AES_ROUND_KEY_SIZE);
+        aes_key_schedule_128_dec(keys + AES_BLOCK_SIZE*i, records[i].dec);
+        records[i].key_id = key_ids[i];
+        records[i].checksum = ks_checksum(&records[i], offsetof(ks_record, checksum));
+        for (s = ks_hash(key_ids[i]) & (nslots - 1); slots[s].record != 0; s = (s + 1) & (nslots - 1)) {
+            if (slots[s].key_id == key_ids[i]) {
+                ok = 0;
+                break;
+            }
+        }
+        slots[s].key_id = key_ids[i];
+        slots[s].record = (uint32_t)i + 1;
+    }
+
+    if (ok) {
+        // per process, so builders racing on the same path each rename a whole file
+        sprintf(tmp, "%s.%lu.tmp", path, (unsigned long)getpid());
+        f = fopen(tmp, "wb");
+        ok = f != NULL;
+        if (ok) {
+            ok = fwrite(file, 1, size, f) == size;
+            ok = fflush(f) == 0 && fsync(fileno(f)) == 0 && ok;
+            ok = fclose(f) == 0 && ok;
+            ok = ok && rename(tmp, path) == 0;
+            if (!ok) {
+                remove(tmp);
+            }
+        }
+    }
+
+    // the buffers hold round keys
+    aes_key_wipe(file, size);
+    aes_key_wipe(roundkeys, (size_t)nkeys * AES_ROUND_KEY_SIZE);
+    free(file);
+    free(roundkeys);
+    free(tmp);
+    return ok ? 0 : -1;
+}
+
+aes_keystore *aes_keystore_open(const char *path) {
+
+    aes_keystore *ks;
+    const ks_header *h;
+    struct stat st;
+    void *map;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < KS_PAGE) {
+        close(fd);
+        return NULL;
+    }
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    h = map;
+    if (memcmp(h->magic, KS_MAGIC, sizeof(KS_MAGIC)) != 0 || h->version != AES_KEYSTORE_VERSION ||
+        h->byte_order != KS_BYTE_ORDER || h->page_size != KS_PAGE || h->record_size != sizeof(ks_record) ||
+        h->checksum != ks_checksum(h, offsetof(ks_header, checksum)) ||
+        h->file_size != (uint64_t)st.st_size || h->nkeys > UINT32_MAX ||
+        h->nslots == 0 || (h->nslots & (h->nslots - 1)) != 0 || h->nslots < h->nkeys ||
+        // bounded by the file before they are multiplied out
+        h->nslots > h->file_size / sizeof(ks_slot) || h->nkeys > h->file_size / sizeof(ks_record) ||
+        h->index_offset != KS_PAGE || h->records_offset != KS_PAGE + ks_page_up(h->nslots * sizeof(ks_slot)) ||
+        h->records_offset + h->nkeys * sizeof(ks_record) > h->file_size) {
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+
+    ks = malloc(sizeof(aes_keystore));
+    // one byte per record; calloc gets fresh zero pages, so this is not a pass over nkeys either
+    if (ks == NULL || (ks->state = calloc(h->nkeys + 1, 1)) == NULL) {
+        free(ks);
+        munmap(map, (size_t)st.st_size);
+        return NULL;
+    }
+    ks->map = map;
+    ks->size = (size_t)st.st_size;
+    ks->header = h;
+    ks->slots = (const ks_slot *)(ks->map + h->index_offset);
+    ks->records = (const ks_record *)(ks->map + h->records_offset);
+    // lookups touch one slot and one record each, read-ahead only costs I/O
+    madvise(ks->map, ks->size, MADV_RANDOM);
+    return ks;
+}
+
+void aes_keystore_close(aes_keystore *ks) {
+    if (ks == NULL) {
+        return;
+    }
+    munmap(ks->map, ks->size);
+    free(ks->state);
+    free(ks);
+}
+
+uint32_t aes_keystore_count(const aes_keystore *ks) {
+    return (uint32_t)ks->header->nkeys;
+}
+
+/*
+ * Racing threads may both check the same record, they store the same
+ * answer. The state byte only ever moves away from KS_UNCHECKED.
+ */
+static int ks_check(aes_keystore *ks, uint32_t r) {
+
+    const ks_record *rec = &ks->records[r];
+    uint8_t state = __atomic_load_n(&ks->state[r], __ATOMIC_ACQUIRE);
+
+    if (state == KS_UNCHECKED) {
+        state = rec->checksum == ks_checksum(rec, offsetof(ks_record, checksum)) ? KS_VALID : KS_BAD;
+        __atomic_store_n(&ks->state[r], state, __ATOMIC_RELEASE);
+    }
+    return state == KS_VALID;
+}
+
+int aes_keystore_get(aes_keystore *ks, uint64_t key_id, const uint8_t **enc, const uint8_t **dec) {
+
+    uint64_t mask = ks->header->nslots - 1;
+    uint64_t s, n;
+    uint32_t r;
+
+    // bounded, so a damaged index cannot loop forever
+    for (s = ks_hash(key_id) & mask, n = 0; n <= mask; s = (s + 1) & mask, ++n) {
+        r = ks->slots[s].record;
+        if (r == 0) {
+            break;
+        }
+        if (ks->slots[s].key_id != key_id) {
+            continue;
+        }
+        if (r > ks->header->nkeys) {
+            return AES_KEYSTORE_CORRUPT;
+        }
+        --r;
+        if (!ks_check(ks, r) || ks->records[r].key_id != key_id) {
+            return AES_KEYSTORE_CORRUPT;
+        }
+        if (enc != NULL) {
+            *enc = ks->records[r].enc;
+        }
+        if (dec != NULL) {
+            *dec = ks->records[r].dec;
+        }
+        return AES_KEYSTORE_OK;
+    }
+    return AES_KEYSTORE_UNKNOWN;
+}
+
+uint32_t aes_keystore_validate(aes_keystore *ks, uint32_t first, uint32_t count) {
+
+    uint32_t nkeys = aes_keystore_count(ks);
+    uint32_t r, bad = 0;
+
+    if (first >= nkeys) {
+        return 0;
+    }
+    if (count > nkeys - first) {
+        count = nkeys - first;
+    }
+    for (r = first; r < first + count; ++r) {
+        bad += !ks_check(ks, r);
+    }
+    return bad;
+}
+
+#endif
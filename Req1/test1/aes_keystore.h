@@ -0,0 +1,88 @@
+/*
+ * aes_keystore.h
+ *
+ * Precomputed AES-128 schedules on disk, for services that come up with many
+ * keys. aes_keystore_build expands the keys once and writes them to a file;
+ * aes_keystore_open maps that file and only checks its header, so opening
+ * costs the same for ten keys or a million. Each record is checked the first
+ * time it is looked up, and aes_keystore_validate can walk the rest in the
+ * background while requests are already being served.
+ *
+ * File format, version 1, all fields in the byte order of the writer (the
+ * header records it) and every section starting on a 4 KB page:
+ *
+ *   page 0         header: magic "AESKSTR", version, section offsets and
+ *                  sizes, checksum of the header
+ *   index          open-addressed hash table of 16-byte slots {key id,
+ *                  record + 1}, a power of two at least twice the key count,
+ *                  0 marks an empty slot
+ *   records        384 bytes per key: encryption schedule, 16 bytes of padding,
+ *                  decryption schedule (aes_key_schedule_128_dec), key id,
+ *                  checksum; both schedules start on a 64-byte boundary
+ *
+ * The checksums catch torn writes and bit rot, not tampering. The file holds
+ * the round keys in clear, protect it like the keys themselves.
+ *
+ */
+#ifndef AES_KEYSTORE_H
+#define AES_KEYSTORE_H
+#include <stdint.h>
+#include "aes_config.h"
+
+#if AES_HAVE_MMAP
+
+#define AES_KEYSTORE_VERSION    1
+
+#define AES_KEYSTORE_OK         0
+#define AES_KEYSTORE_UNKNOWN    -1  // no such key id
+#define AES_KEYSTORE_CORRUPT    -2  // the record fails its checksum
+
+typedef struct aes_keystore aes_keystore;
+
+/**
+ * @purpose:            Expand nkeys keys with aes_key_schedule_128_batch and write them as a
+ *                      key store. The file is written next to path and renamed over it, so
+ *                      readers see either the old store or the complete new one.
+ * @par[in]path:        file to create or replace
+ * @par[in]key_ids:     nkeys distinct ids
+ * @par[in]keys:        nkeys * 16 bytes of master keys, in the order of key_ids
+ * @return:             0 on success, -1 on an I/O error, duplicate ids or out of memory
+ */
+int aes_keystore_build(const char *path, const uint64_t *key_ids, const uint8_t *keys, uint32_t nkeys);
+
+/**
+ * @purpose:            Map a key store read-only. Checks the header against the file, nothing else.
+ * @return:             the store, or NULL if the file cannot be mapped or is not a version 1
+ *                      store of this byte order
+ */
+aes_keystore *aes_keystore_open(const char *path);
+
+/**
+ * @purpose:            Unmap the store. Pointers from aes_keystore_get become invalid.
+ */
+void aes_keystore_close(aes_keystore *ks);
+
+/**
+ * @purpose:            Number of keys in the store
+ */
+uint32_t aes_keystore_count(const aes_keystore *ks);
+
+/**
+ * @purpose:            Find the schedules of a key, in place in the mapping. The record is checked
+ *                      on its first lookup and the result remembered. Thread safe.
+ * @par[in]key_id:      key id
+ * @par[out]enc:        176 bytes for aes_encrypt_128 and aes_decrypt_128, may be NULL
+ * @par[out]dec:        176 bytes for aes_decrypt_128_ttable, may be NULL
+ * @return:             AES_KEYSTORE_OK, AES_KEYSTORE_UNKNOWN or AES_KEYSTORE_CORRUPT
+ */
+int aes_keystore_get(aes_keystore *ks, uint64_t key_id, const uint8_t **enc, const uint8_t **dec);
+
+/**
+ * @purpose:            Check records first .. first+count-1 now (clamped to the store), e.g. from
+ *                      a warm-up thread, which also faults their pages in.
+ * @return:             number of corrupt records among them
+ */
+uint32_t aes_keystore_validate(aes_keystore *ks, uint32_t first, uint32_t count);
+
+#endif
+#endif
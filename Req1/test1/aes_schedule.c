@@ -14,13 +14,17 @@
 #include <stdint.h>
 
 
+#include "aes_config.h"
+#include "aes_gf.h"
 #include "aes_schedule.h"
 #include "aes_encrypt.h"
+#include "aes_aesni.h"
 /*
  * round constants
  */
 static uint8_t RC[10] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
-void aes_key_schedule_128(const uint8_t *key, uint8_t *roundkeys) {
+
+void aes_key_schedule_128_byte(const uint8_t *key, uint8_t *roundkeys) {
 
     uint8_t temp[4];
     uint8_t *last4bytes; // point to the last 4 bytes of one round
@@ -34,10 +38,18 @@ void aes_key_schedule_128(const uint8_t *key, uint8_t *roundkeys) {
     last4bytes = roundkeys-4;
     for (i = 0; i < AES_ROUNDS; ++i) {
         // k0-k3 for next round
+#if AES_SBOX_COMPUTED
+        temp[3] = *last4bytes++;
+        temp[0] = *last4bytes++;
+        temp[1] = *last4bytes++;
+        temp[2] = *last4bytes++;
+        aes_gf_sub_bytes(temp, 4);
+#else
         temp[3] = SBOX[*last4bytes++];
         temp[0] = SBOX[*last4bytes++];
         temp[1] = SBOX[*last4bytes++];
         temp[2] = SBOX[*last4bytes++];
+#endif
         temp[0] ^= RC[i];
         lastround = roundkeys-16;
         *roundkeys++ = temp[0] ^ *lastround++;
@@ -61,3 +73,221 @@ void aes_key_schedule_128(const uint8_t *key, uint8_t *roundkeys) {
         *roundkeys++ = *last4bytes++ ^ *lastround++;
     }
 }
+
+void aes_key_schedule_128_next(uint8_t *roundkey, uint8_t round) {
+
+    uint8_t temp[4];
+    uint8_t i;
+
+#if AES_SBOX_COMPUTED
+    temp[0] = roundkey[13];
+    temp[1] = roundkey[14];
+    temp[2] = roundkey[15];
+    temp[3] = roundkey[12];
+    aes_gf_sub_bytes(temp, 4);
+#else
+    temp[0] = SBOX[roundkey[13]];
+    temp[1] = SBOX[roundkey[14]];
+    temp[2] = SBOX[roundkey[15]];
+    temp[3] = SBOX[roundkey[12]];
+#endif
+    roundkey[0] ^= temp[0] ^ RC[round-1];
+    roundkey[1] ^= temp[1];
+    roundkey[2] ^= temp[2];
+    roundkey[3] ^= temp[3];
+    // each later word xors in the new word before it
+    for (i = 4; i < 16; ++i) {
+        roundkey[i] ^= roundkey[i-4];
+    }
+}
+
+void aes_key_schedule_128_prev(uint8_t *roundkey, uint8_t round) {
+
+    uint8_t temp[4];
+    uint8_t i;
+
+    // words 1..3 first, from the back, which restores word 3 of the previous key
+    for (i = 15; i >= 4; --i) {
+        roundkey[i] ^= roundkey[i-4];
+    }
+#if AES_SBOX_COMPUTED
+    temp[0] = roundkey[13];
+    temp[1] = roundkey[14];
+    temp[2] = roundkey[15];
+    temp[3] = roundkey[12];
+    aes_gf_sub_bytes(temp, 4);
+#else
+    temp[0] = SBOX[roundkey[13]];
+    temp[1] = SBOX[roundkey[14]];
+    temp[2] = SBOX[roundkey[15]];
+    temp[3] = SBOX[roundkey[12]];
+#endif
+    roundkey[0] ^= temp[0] ^ RC[round-1];
+    roundkey[1] ^= temp[1];
+    roundkey[2] ^= temp[2];
+    roundkey[3] ^= temp[3];
+}
+
+void aes_key_schedule_128_last(const uint8_t *key, uint8_t *lastkey) {
+
+    uint8_t i;
+
+    for (i = 0; i < AES_BLOCK_SIZE; ++i) {
+        lastkey[i] = key[i];
+    }
+    for (i = 1; i <= AES_ROUNDS; ++i) {
+        aes_key_schedule_128_next(lastkey, i);
+    }
+}
+
+/*
+ * FIPS-197 expansion for a key of nk words. Every nk-th word the previous
+ * word is rotated, substituted and xored with a round constant, and for
+ * AES-256 the word in the middle of each key length is substituted too.
+ * The new word is that xor the word nk places back.
+ */
+static AES_FORCE_INLINE void key_schedule_nk(const uint8_t *key, uint8_t *roundkeys, const uint8_t nk, const uint8_t rounds) {
+
+    uint8_t temp[4], t;
+    uint8_t i, k;
+
+    for (i = 0; i < 4*nk; ++i) {
+        roundkeys[i] = key[i];
+    }
+
+    for (i = nk; i < 4*(rounds+1); ++i) {
+        for (k = 0; k < 4; ++k) {
+            temp[k] = roundkeys[4*(i-1)+k];
+        }
+        if (i % nk == 0) {
+            t = temp[0];
+#if AES_SBOX_COMPUTED
+            temp[0] = temp[1];
+            temp[1] = temp[2];
+            temp[2] = temp[3];
+            temp[3] = t;
+            aes_gf_sub_bytes(temp, 4);
+            temp[0] ^= RC[i/nk-1];
+#else
+            temp[0] = SBOX[temp[1]] ^ RC[i/nk-1];
+            temp[1] = SBOX[temp[2]];
+            temp[2] = SBOX[temp[3]];
+            temp[3] = SBOX[t];
+#endif
+        } else if (nk > 6 && i % nk == 4) {
+#if AES_SBOX_COMPUTED
+            aes_gf_sub_bytes(temp, 4);
+#else
+            for (k = 0; k < 4; ++k) {
+                temp[k] = SBOX[temp[k]];
+            }
+#endif
+        }
+        for (k = 0; k < 4; ++k) {
+            roundkeys[4*i+k] = roundkeys[4*(i-nk)+k] ^ temp[k];
+        }
+    }
+}
+
+void aes_key_schedule_192(const uint8_t *key, uint8_t *roundkeys) {
+    key_schedule_nk(key, roundkeys, 6, AES_192_ROUNDS);
+}
+
+void aes_key_schedule_256(const uint8_t *key, uint8_t *roundkeys) {
+    key_schedule_nk(key, roundkeys, 8, AES_256_ROUNDS);
+}
+
+#if AES_ENGINE == AES_ENGINE_AUTO && AES_HAVE_AESNI
+static void key_schedule_resolve(const uint8_t *key, uint8_t *roundkeys);
+static void (*key_schedule_engine)(const uint8_t *, uint8_t *) = key_schedule_resolve;
+
+static void key_schedule_resolve(const uint8_t *key, uint8_t *roundkeys) {
+    key_schedule_engine = aes_cpu_has_aesni() ? aes_key_schedule_128_aesni : aes_key_schedule_128_byte;
+    key_schedule_engine(key, roundkeys);
+}
+#endif
+
+void aes_key_schedule_128(const uint8_t *key, uint8_t *roundkeys) {
+#if AES_ENGINE == AES_ENGINE_AUTO && AES_HAVE_AESNI
+    key_schedule_engine(key, roundkeys);
+#else
+    aes_key_schedule_128_byte(key, roundkeys);
+#endif
+}
+
+/*
+ * Keys per pass of the portable batch. The RotWord bytes of all of them are
+ * substituted together, which lets the computed S-box fill its eight-byte
+ * passes (two keys each) instead of running half empty on one key's word.
+ */
+#define KEY_BATCH   4
+
+void aes_key_schedule_128_byte_batch(const uint8_t *keys, uint8_t *roundkeys, uint32_t nkeys) {
+
+    uint8_t temp[4*KEY_BATCH];
+    uint8_t *rk;
+    uint8_t i, j, k, n;
+
+    while (nkeys > 0) {
+        n = nkeys < KEY_BATCH ? (uint8_t)nkeys : KEY_BATCH;
+        for (k = 0; k < n; ++k) {
+            for (j = 0; j < 16; ++j) {
+                roundkeys[AES_ROUND_KEY_SIZE*k + j] = keys[16*k + j];
+            }
+        }
+        for (i = 0; i < AES_ROUNDS; ++i) {
+            for (k = 0; k < n; ++k) {
+                rk = roundkeys + AES_ROUND_KEY_SIZE*k + 16*i;
+                temp[4*k]   = rk[13];
+                temp[4*k+1] = rk[14];
+                temp[4*k+2] = rk[15];
+                temp[4*k+3] = rk[12];
+            }
+#if AES_SBOX_COMPUTED
+            aes_gf_sub_bytes(temp, 4*n);
+#else
+            for (j = 0; j < 4*n; ++j) {
+                temp[j] = SBOX[temp[j]];
+            }
+#endif
+            for (k = 0; k < n; ++k) {
+                rk = roundkeys + AES_ROUND_KEY_SIZE*k + 16*i;
+                temp[4*k] ^= RC[i];
+                for (j = 0; j < 4; ++j) {
+                    rk[16+j] = rk[j] ^ temp[4*k+j];
+                }
+                for (j = 4; j < 16; ++j) {
+                    rk[16+j] = rk[j] ^ rk[12+j];
+                }
+            }
+        }
+        keys += 16*n;
+        roundkeys += AES_ROUND_KEY_SIZE*n;
+        nkeys -= n;
+    }
+}
+
+void aes_key_schedule_128_batch(const uint8_t *keys, uint8_t *roundkeys, uint32_t nkeys) {
+#if AES_ENGINE == AES_ENGINE_AUTO && AES_HAVE_AESNI
+    if (aes_cpu_has_aesni()) {
+        aes_key_schedule_128_aesni_batch(keys, roundkeys, nkeys);
+        return;
+    }
+#endif
+    aes_key_schedule_128_byte_batch(keys, roundkeys, nkeys);
+}
+
+void aes_key_schedule_128_dec(const uint8_t *key, uint8_t *roundkeys) {
+
+    uint8_t i;
+
+    aes_key_schedule_128(key, roundkeys);
+
+    /*
+     * InvMixColumns on the round keys of rounds 1..9, the first and the
+     * last round keys are used unchanged by the equivalent inverse cipher
+     */
+    for (i = 16; i < AES_ROUND_KEY_SIZE - 16; i += 4) {
+        gf_inv_mix_column(roundkeys + i, roundkeys + i);
+    }
+}
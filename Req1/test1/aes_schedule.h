@@ -15,12 +15,74 @@
 #include <stdint.h>
 
 #define AES_BLOCK_SIZE      16
-#define AES_ROUNDS          10  // 12, 14
+#define AES_ROUNDS          10
 #define AES_ROUND_KEY_SIZE  176 // AES-128 has 10 rounds, and there is a AddRoundKey before first round. (10+1)x16=176.
+#define AES_192_ROUNDS      12
+#define AES_192_ROUND_KEY_SIZE  208 // (12+1)x16
+#define AES_256_ROUNDS      14
+#define AES_256_ROUND_KEY_SIZE  240 // (14+1)x16
 /**
  * @purpose:            Key schedule for AES-128
  * @par[in]key:         16 bytes of master keys
  * @par[out]roundkeys:  176 bytes of round keys
  */
 void aes_key_schedule_128(const uint8_t *key, uint8_t *roundkeys);
+/**
+ * @purpose:            Byte-wise key schedule behind aes_key_schedule_128 when AES-NI is not used.
+ */
+void aes_key_schedule_128_byte(const uint8_t *key, uint8_t *roundkeys);
+/**
+ * @purpose:            Key schedules for many keys at once, e.g. one per session. Uses AES-NI
+ *                      four keys per pass where aes_key_schedule_128 does, the portable batch
+ *                      otherwise. Each schedule equals aes_key_schedule_128 of its key.
+ * @par[in]keys:        nkeys * 16 bytes of master keys, back to back
+ * @par[out]roundkeys:  nkeys * 176 bytes, the schedule of key i at roundkeys + 176*i
+ * @par[in]nkeys:       number of keys, 0 is allowed
+ */
+void aes_key_schedule_128_batch(const uint8_t *keys, uint8_t *roundkeys, uint32_t nkeys);
+/**
+ * @purpose:            Portable batch behind aes_key_schedule_128_batch, four keys per pass
+ *                      with their S-box lookups grouped.
+ */
+void aes_key_schedule_128_byte_batch(const uint8_t *keys, uint8_t *roundkeys, uint32_t nkeys);
+/**
+ * @purpose:            Decryption key schedule for the equivalent inverse cipher
+ *                      (aes_decrypt_128_ttable). Same layout as aes_key_schedule_128,
+ *                      but round keys 1..9 have InvMixColumns applied.
+ * @par[in]key:         16 bytes of master keys
+ * @par[out]roundkeys:  176 bytes of decryption round keys
+ */
+void aes_key_schedule_128_dec(const uint8_t *key, uint8_t *roundkeys);
+/**
+ * @purpose:            One step of the AES-128 key schedule in place, for engines that expand
+ *                      the key on the fly instead of reading 176 bytes of round keys.
+ * @par[in,out]roundkey: 16 bytes, round key round-1 on entry, round key round on return
+ * @par[in]round:       1..10
+ */
+void aes_key_schedule_128_next(uint8_t *roundkey, uint8_t round);
+/**
+ * @purpose:            The inverse step: round key round-1 from round key round, in place.
+ * @par[in,out]roundkey: 16 bytes, round key round on entry, round key round-1 on return
+ * @par[in]round:       1..10
+ */
+void aes_key_schedule_128_prev(uint8_t *roundkey, uint8_t round);
+/**
+ * @purpose:            Last AES-128 round key, the starting point of aes_decrypt_128_otf.
+ *                      key and lastkey may point to the same memory.
+ * @par[in]key:         16 bytes of master keys
+ * @par[out]lastkey:    16 bytes, round key 10
+ */
+void aes_key_schedule_128_last(const uint8_t *key, uint8_t *lastkey);
+/**
+ * @purpose:            Key schedule for AES-192
+ * @par[in]key:         24 bytes of master keys
+ * @par[out]roundkeys:  208 bytes of round keys
+ */
+void aes_key_schedule_192(const uint8_t *key, uint8_t *roundkeys);
+/**
+ * @purpose:            Key schedule for AES-256
+ * @par[in]key:         32 bytes of master keys
+ * @par[out]roundkeys:  240 bytes of round keys
+ */
+void aes_key_schedule_256(const uint8_t *key, uint8_t *roundkeys);
 #endif
@@ -0,0 +1,50 @@
+/*
+ * aes_ttable.h
+ *
+ * 32-bit T-table engine. Uses 4 KB of lookup tables per direction (1 or 2 KB with
+ * AES_TTABLE_LAYOUT, see aes_config.h), so it is meant for hosts and not for the AVR targets.
+ *
+ */
+#ifndef AES_TTABLE_H
+#define AES_TTABLE_H
+#include <stdint.h>
+#include "aes_config.h"
+
+/**
+ * @purpose:            Encryption with the T-table engine. Same contract as aes_encrypt_128.
+ *                      The plaintext and ciphertext may point to the same memory
+ * @par[in]roundkeys:   round keys from aes_key_schedule_128
+ * @par[in]plaintext:   plain text
+ * @par[out]ciphertext: cipher text
+ */
+void aes_encrypt_128_ttable(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+
+/**
+ * @purpose:            The same T-table encryption for AES-192 and AES-256, round keys from
+ *                      aes_key_schedule_192/aes_key_schedule_256.
+ */
+void aes_encrypt_192_ttable(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+void aes_encrypt_256_ttable(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+
+/**
+ * @purpose:            Decryption with the T-table engine (equivalent inverse cipher).
+ *                      The ciphertext and plaintext may point to the same memory
+ * @par[in]roundkeys:   decryption round keys from aes_key_schedule_128_dec,
+ *                      NOT the ones from aes_key_schedule_128
+ * @par[in]ciphertext:  cipher text
+ * @par[out]plaintext:  plain text
+ */
+void aes_decrypt_128_ttable(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+
+/**
+ * @purpose:            The 128-bit engines in one fixed layout each, regardless of
+ *                      AES_TTABLE_LAYOUT, e.g. to choose a layout at run time or to
+ *                      compare them. Same contracts as above.
+ */
+void aes_encrypt_128_ttable_4k(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+void aes_encrypt_128_ttable_2k(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+void aes_encrypt_128_ttable_1k(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+void aes_decrypt_128_ttable_4k(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+void aes_decrypt_128_ttable_2k(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+void aes_decrypt_128_ttable_1k(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+#endif
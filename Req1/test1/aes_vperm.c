@@ -0,0 +1,219 @@
+/*
+ * aes_vperm.c
+ *
+ * Constant-time single-block engine built on pshufb (SSSE3), after the
+ * vector-permute technique. SubBytes is computed instead of looked up:
+ *
+ *  - the byte is mapped into the tower field GF((2^4)^2) = GF(2^4)[y]/(y^2 + y + 8),
+ *    GF(2^4) = GF(2)[x]/(x^4 + x + 1), with one pshufb per nibble,
+ *  - (a.y + b)^-1 = (a.y + (a + b)) / (8.a^2 + a.b + b^2) is evaluated with 16-entry
+ *    log/exp/square tables, every lookup being a pshufb on a register,
+ *  - the result is mapped back, through the affine transform for SubBytes.
+ *
+ * The round structure and the round keys are the ones of aes_encrypt_128 and
+ * aes_decrypt_128. SBOX and INV_SBOX are not read, and all loads are at fixed
+ * addresses.
+ *
+ */
+#include <stdint.h>
+#include "aes_config.h"
+#include "aes_encrypt.h"
+#include "aes_vperm.h"
+
+#if AES_HAVE_SSSE3
+#include <cpuid.h>
+#include <tmmintrin.h>
+
+#define VP_TARGET   __attribute__((target("ssse3")))
+#define VP_ALIGN    __attribute__((aligned(16)))
+
+/*
+ * GF(2^4) with generator x: log (0x80 for log 0, so that pshufb yields 0 further on),
+ * log of the inverse, exp, and the two squares of the norm 8.a^2 + b^2
+ */
+static const uint8_t VP_LOG[16]        VP_ALIGN = {0x80, 0x00, 0x01, 0x04, 0x02, 0x08, 0x05, 0x0a, 0x03, 0x0e, 0x09, 0x07, 0x06, 0x0d, 0x0b, 0x0c};
+static const uint8_t VP_LOGINV[16]     VP_ALIGN = {0x80, 0x00, 0x0e, 0x0b, 0x0d, 0x07, 0x0a, 0x05, 0x0c, 0x01, 0x06, 0x08, 0x09, 0x02, 0x04, 0x03};
+static const uint8_t VP_EXP[16]        VP_ALIGN = {0x01, 0x02, 0x04, 0x08, 0x03, 0x06, 0x0c, 0x0b, 0x05, 0x0a, 0x07, 0x0e, 0x0f, 0x0d, 0x09, 0x00};
+static const uint8_t VP_LAMSQ[16]      VP_ALIGN = {0x00, 0x08, 0x06, 0x0e, 0x0b, 0x03, 0x0d, 0x05, 0x0a, 0x02, 0x0c, 0x04, 0x01, 0x09, 0x07, 0x0f};
+static const uint8_t VP_SQ[16]         VP_ALIGN = {0x00, 0x01, 0x04, 0x05, 0x03, 0x02, 0x07, 0x06, 0x0c, 0x0d, 0x08, 0x09, 0x0f, 0x0e, 0x0b, 0x0a};
+
+/*
+ * Nibble tables into the tower field and out of it. The encryption output applies
+ * the affine transform, the decryption input its inverse.
+ */
+static const uint8_t VP_ENC_IN_LO[16]  VP_ALIGN = {0x00, 0x01, 0x20, 0x21, 0x46, 0x47, 0x66, 0x67, 0x4c, 0x4d, 0x6c, 0x6d, 0x0a, 0x0b, 0x2a, 0x2b};
+static const uint8_t VP_ENC_IN_HI[16]  VP_ALIGN = {0x00, 0x3c, 0xd5, 0xe9, 0x34, 0x08, 0xe1, 0xdd, 0xe5, 0xd9, 0x30, 0x0c, 0xd1, 0xed, 0x04, 0x38};
+static const uint8_t VP_ENC_OUT_LO[16] VP_ALIGN = {0x00, 0x1f, 0xb2, 0xad, 0xab, 0xb4, 0x19, 0x06, 0x36, 0x29, 0x84, 0x9b, 0x9d, 0x82, 0x2f, 0x30};
+static const uint8_t VP_ENC_OUT_HI[16] VP_ALIGN = {0x63, 0x31, 0x5d, 0x0f, 0x06, 0x54, 0x38, 0x6a, 0x03, 0x51, 0x3d, 0x6f, 0x66, 0x34, 0x58, 0x0a};
+static const uint8_t VP_DEC_IN_LO[16]  VP_ALIGN = {0x00, 0x58, 0x9f, 0xc7, 0x98, 0xc0, 0x07, 0x5f, 0x28, 0x70, 0xb7, 0xef, 0xb0, 0xe8, 0x2f, 0x77};
+static const uint8_t VP_DEC_IN_HI[16]  VP_ALIGN = {0x47, 0x31, 0x3e, 0x48, 0xbe, 0xc8, 0xc7, 0xb1, 0xd5, 0xa3, 0xac, 0xda, 0x2c, 0x5a, 0x55, 0x23};
+static const uint8_t VP_DEC_OUT_LO[16] VP_ALIGN = {0x00, 0x01, 0x5c, 0x5d, 0xe0, 0xe1, 0xbc, 0xbd, 0x50, 0x51, 0x0c, 0x0d, 0xb0, 0xb1, 0xec, 0xed};
+static const uint8_t VP_DEC_OUT_HI[16] VP_ALIGN = {0x00, 0xa2, 0x02, 0xa0, 0xb8, 0x1a, 0xba, 0x18, 0xdb, 0x79, 0xd9, 0x7b, 0x63, 0xc1, 0x61, 0xc3};
+
+/*
+ * Byte permutations: ShiftRows and InvShiftRows, each also followed by a rotation of
+ * the rows inside every column by 1, 2 and 3, and the plain rotation by 2
+ */
+static const uint8_t VP_SR[16]       VP_ALIGN = {0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11};
+static const uint8_t VP_SR_ROT1[16]  VP_ALIGN = {5, 10, 15, 0, 9, 14, 3, 4, 13, 2, 7, 8, 1, 6, 11, 12};
+static const uint8_t VP_SR_ROT2[16]  VP_ALIGN = {10, 15, 0, 5, 14, 3, 4, 9, 2, 7, 8, 13, 6, 11, 12, 1};
+static const uint8_t VP_SR_ROT3[16]  VP_ALIGN = {15, 0, 5, 10, 3, 4, 9, 14, 7, 8, 13, 2, 11, 12, 1, 6};
+static const uint8_t VP_ISR[16]      VP_ALIGN = {0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3};
+static const uint8_t VP_ISR_ROT1[16] VP_ALIGN = {1, 14, 11, 4, 5, 2, 15, 8, 9, 6, 3, 12, 13, 10, 7, 0};
+static const uint8_t VP_ISR_ROT2[16] VP_ALIGN = {2, 15, 8, 5, 6, 3, 12, 9, 10, 7, 0, 13, 14, 11, 4, 1};
+static const uint8_t VP_ISR_ROT3[16] VP_ALIGN = {3, 12, 9, 6, 7, 0, 13, 10, 11, 4, 1, 14, 15, 8, 5, 2};
+static const uint8_t VP_ROT2[16]     VP_ALIGN = {2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13};
+
+#define LOAD(t)         _mm_load_si128((const __m128i *)(t))
+#define LOOKUP(t, i)    _mm_shuffle_epi8(LOAD(t), (i))
+#define PERMUTE(x, p)   _mm_shuffle_epi8((x), LOAD(p))
+
+// cached the same way as aes_cpu_has_aesni, first calls may race
+int aes_cpu_has_ssse3(void) {
+
+    static int has_ssse3 = -1;
+    unsigned int eax, ebx, ecx, edx;
+    int has = __atomic_load_n(&has_ssse3, __ATOMIC_RELAXED);
+
+    if (has < 0) {
+        has = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSSE3);
+        __atomic_store_n(&has_ssse3, has, __ATOMIC_RELAXED);
+    }
+    return has;
+}
+
+/**
+ * @purpose:    a.b in GF(2^4) from the logs of a and b. The saturating add keeps
+ *              the 0x80 mark of a zero operand, and 15..28 is moved to 16..29 so
+ *              that the low nibble is the sum modulo 15.
+ */
+static inline VP_TARGET __m128i vp_exp_add(__m128i la, __m128i lb) {
+    __m128i s = _mm_adds_epu8(la, lb);
+    s = _mm_sub_epi8(s, _mm_cmpgt_epi8(s, _mm_set1_epi8(14)));
+    return LOOKUP(VP_EXP, s);
+}
+
+/**
+ * @purpose:    SubBytes or InvSubBytes on all 16 bytes, depending on the nibble tables.
+ */
+static inline VP_TARGET __m128i vp_sub_bytes(__m128i x, const uint8_t *in_lo, const uint8_t *in_hi,
+                                             const uint8_t *out_lo, const uint8_t *out_hi) {
+    const __m128i m0f = _mm_set1_epi8(0x0f);
+    __m128i a, b, la, li, d;
+
+    x = _mm_xor_si128(LOOKUP(in_lo, _mm_and_si128(x, m0f)),
+                      LOOKUP(in_hi, _mm_and_si128(_mm_srli_epi16(x, 4), m0f)));
+    a = _mm_and_si128(_mm_srli_epi16(x, 4), m0f);
+    b = _mm_and_si128(x, m0f);
+
+    // d = 8.a^2 + a.b + b^2, li = log(1/d)
+    la = LOOKUP(VP_LOG, a);
+    d  = _mm_xor_si128(vp_exp_add(la, LOOKUP(VP_LOG, b)),
+                       _mm_xor_si128(LOOKUP(VP_LAMSQ, a), LOOKUP(VP_SQ, b)));
+    li = LOOKUP(VP_LOGINV, d);
+
+    // high nibble a/d, low nibble (a + b)/d, straight into the output tables
+    return _mm_xor_si128(LOOKUP(out_hi, vp_exp_add(la, li)),
+                         LOOKUP(out_lo, vp_exp_add(LOOKUP(VP_LOG, _mm_xor_si128(a, b)), li)));
+}
+
+static inline VP_TARGET __m128i vp_mul2(__m128i x) {
+    return _mm_xor_si128(_mm_add_epi8(x, x),
+                         _mm_and_si128(_mm_cmpgt_epi8(_mm_setzero_si128(), x), _mm_set1_epi8(0x1b)));
+}
+
+/**
+ * @purpose:    MixColumns fused with the row permutation p0 in front of it (encryption)
+ *              or behind it (decryption): 02.(s0 ^ s1) ^ s1 ^ s2 ^ s3, where sk is the
+ *              state permuted by pk = p0 then a rotation by k rows. The four pshufb are
+ *              independent, so only one of them sits on the round's critical path.
+ * @par[in]:    s: state, p0..p3: permutation tables
+ */
+static inline VP_TARGET __m128i vp_mix_columns(__m128i s, const uint8_t *p0, const uint8_t *p1,
+                                               const uint8_t *p2, const uint8_t *p3) {
+    __m128i s0 = PERMUTE(s, p0);
+    __m128i s1 = PERMUTE(s, p1);
+    __m128i s2 = PERMUTE(s, p2);
+    __m128i s3 = PERMUTE(s, p3);
+    return _mm_xor_si128(_mm_xor_si128(vp_mul2(_mm_xor_si128(s0, s1)), s1), _mm_xor_si128(s2, s3));
+}
+
+/**
+ * @purpose:    InvMixColumns = MixColumns after s ^= 04.(s ^ rot2(s)), like aes_decrypt.c,
+ *              followed by InvShiftRows
+ */
+static inline VP_TARGET __m128i vp_inv_mix_shift(__m128i s) {
+    s = _mm_xor_si128(s, vp_mul2(vp_mul2(_mm_xor_si128(s, PERMUTE(s, VP_ROT2)))));
+    return vp_mix_columns(s, VP_ISR, VP_ISR_ROT1, VP_ISR_ROT2, VP_ISR_ROT3);
+}
+
+static AES_FORCE_INLINE VP_TARGET void encrypt_vperm(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext, const uint8_t rounds) {
+
+    const __m128i *rk = (const __m128i *)roundkeys;
+    __m128i s;
+    uint8_t j;
+
+    // first AddRoundKey
+    s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)plaintext), _mm_loadu_si128(rk));
+
+    // 9, 11 or 13 rounds
+    for (j = 1; j < rounds; ++j) {
+        s = vp_sub_bytes(s, VP_ENC_IN_LO, VP_ENC_IN_HI, VP_ENC_OUT_LO, VP_ENC_OUT_HI);
+        s = vp_mix_columns(s, VP_SR, VP_SR_ROT1, VP_SR_ROT2, VP_SR_ROT3);
+        s = _mm_xor_si128(s, _mm_loadu_si128(rk + j));
+    }
+
+    // last round
+    s = vp_sub_bytes(s, VP_ENC_IN_LO, VP_ENC_IN_HI, VP_ENC_OUT_LO, VP_ENC_OUT_HI);
+    s = PERMUTE(s, VP_SR);
+    s = _mm_xor_si128(s, _mm_loadu_si128(rk + rounds));
+    _mm_storeu_si128((__m128i *)ciphertext, s);
+}
+
+static AES_FORCE_INLINE VP_TARGET void decrypt_vperm(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext, const uint8_t rounds) {
+
+    const __m128i *rk = (const __m128i *)roundkeys;
+    __m128i s;
+    uint8_t j;
+
+    // first round
+    s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)ciphertext), _mm_loadu_si128(rk + rounds));
+    s = PERMUTE(s, VP_ISR);
+    s = vp_sub_bytes(s, VP_DEC_IN_LO, VP_DEC_IN_HI, VP_DEC_OUT_LO, VP_DEC_OUT_HI);
+
+    for (j = rounds - 1; j > 0; --j) {
+        s = _mm_xor_si128(s, _mm_loadu_si128(rk + j));
+        s = vp_inv_mix_shift(s);
+        s = vp_sub_bytes(s, VP_DEC_IN_LO, VP_DEC_IN_HI, VP_DEC_OUT_LO, VP_DEC_OUT_HI);
+    }
+
+    // last AddRoundKey
+    s = _mm_xor_si128(s, _mm_loadu_si128(rk));
+    _mm_storeu_si128((__m128i *)plaintext, s);
+}
+
+VP_TARGET void aes_encrypt_128_vperm(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext) {
+    encrypt_vperm(roundkeys, plaintext, ciphertext, AES_ROUNDS);
+}
+
+VP_TARGET void aes_encrypt_192_vperm(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext) {
+    encrypt_vperm(roundkeys, plaintext, ciphertext, AES_192_ROUNDS);
+}
+
+VP_TARGET void aes_encrypt_256_vperm(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext) {
+    encrypt_vperm(roundkeys, plaintext, ciphertext, AES_256_ROUNDS);
+}
+
+VP_TARGET void aes_decrypt_128_vperm(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_vperm(roundkeys, ciphertext, plaintext, AES_ROUNDS);
+}
+
+VP_TARGET void aes_decrypt_192_vperm(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_vperm(roundkeys, ciphertext, plaintext, AES_192_ROUNDS);
+}
+
+VP_TARGET void aes_decrypt_256_vperm(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext) {
+    decrypt_vperm(roundkeys, ciphertext, plaintext, AES_256_ROUNDS);
+}
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * aes_vperm.h
+ *
+ * Constant-time single-block engine on SSSE3 (pshufb). Uses the round keys of
+ * aes_key_schedule_128/192/256 for both directions. Only safe to call when
+ * aes_cpu_has_ssse3() says so.
+ *
+ */
+#ifndef AES_VPERM_H
+#define AES_VPERM_H
+#include <stdint.h>
+#include "aes_config.h"
+
+#if AES_HAVE_SSSE3
+
+/**
+ * @purpose:            CPUID check for SSSE3. The answer is cached.
+ * @return:             1 if the vector-permute engine can run on this CPU, 0 otherwise
+ */
+int aes_cpu_has_ssse3(void);
+
+/**
+ * @purpose:            Encryption, same contract as aes_encrypt_128.
+ */
+void aes_encrypt_128_vperm(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+
+/**
+ * @purpose:            Decryption, same contract as aes_decrypt_128.
+ */
+void aes_decrypt_128_vperm(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+
+/**
+ * @purpose:            The same kernels for AES-192 and AES-256.
+ */
+void aes_encrypt_192_vperm(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+void aes_encrypt_256_vperm(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext);
+void aes_decrypt_192_vperm(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+void aes_decrypt_256_vperm(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext);
+
+#endif
+#endif
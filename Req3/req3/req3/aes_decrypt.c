@@ -41,7 +41,7 @@ const static uint8_t INV_SBOX[256] __attribute__((__progmem__))= {
  * just in order to get a higher speed.
  */
 static inline uint8_t mul2(uint8_t a) {
-    return (a&0x80) ? ((a<<1)^0x1b) : (a<<1);
+    return (uint8_t)((a << 1) ^ (-(a >> 7) & 0x1b));
 }
 /**
  * @purpose:    Inverse ShiftRows
@@ -43,7 +43,7 @@ static uint8_t INV_SBOX[256] = {
 
 /*
  inline uint8_t mul2(uint8_t a) {
-    return (a&0x80) ? ((a<<1)^0x1b) : (a<<1);
+    return (uint8_t)((a << 1) ^ (-(a >> 7) & 0x1b));
 }
 remove static and inline from function and extern it from aes_encrypt to save 48 bytes
 */
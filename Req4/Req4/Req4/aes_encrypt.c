@@ -44,7 +44,7 @@
  */
 
  uint8_t mul2(uint8_t a) {
-    return (a&0x80) ? ((a<<1)^0x1b) : (a<<1);
+    return (uint8_t)((a << 1) ^ (-(a >> 7) & 0x1b));
 }
 /**
  * @purpose:    ShiftRows
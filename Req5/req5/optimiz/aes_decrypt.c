@@ -14,6 +14,7 @@
 #include <stdint.h>
 
 #include "aes_decrypt.h"
+#include "aes_roundkeys.h"
 
 
 static uint8_t INV_SBOX[256] = {
@@ -43,7 +44,7 @@ static uint8_t INV_SBOX[256] = {
  */
 __attribute__((always_inline)) static inline uint8_t mul2(register uint8_t a)
 {
-    return (a&0x80) ? ((a<<1)^0x1b) : (a<<1);
+    return (uint8_t)((a << 1) ^ (-(a >> 7) & 0x1b));
 }
 /**
  * @purpose:    Inverse ShiftRows
@@ -76,7 +77,13 @@ static void inv_shift_rows(register uint8_t *state)
     *(state+11) = *(state+15);
     *(state+15) = temp;
 }
-void aes_decrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext, register uint8_t *plaintext)
+/*
+ * Round key byte from RAM, or from flash for aes_decrypt_128_P
+ */
+#define RK(p)   (flash ? pgm_read_byte(p) : *(p))
+
+static inline __attribute__((always_inline)) void decrypt_128( register const uint8_t *roundkeys, register uint8_t *ciphertext,
+                                                               register uint8_t *plaintext, const uint8_t flash)
 {
 
     uint8_t tmp[16];
@@ -93,22 +100,22 @@ void aes_decrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext,
     }
 	*(plaintext+i) = *(ciphertext+i) ^ *(roundkeys+i);
 	*/
-	*(plaintext+0) = *(ciphertext+0) ^ *(roundkeys+0);
-	*(plaintext+1) = *(ciphertext+1) ^ *(roundkeys+1);
-	*(plaintext+2) = *(ciphertext+2) ^ *(roundkeys+2);
-	*(plaintext+3) = *(ciphertext+3) ^ *(roundkeys+3);
-	*(plaintext+4) = *(ciphertext+4) ^ *(roundkeys+4);
-	*(plaintext+5) = *(ciphertext+5) ^ *(roundkeys+5);
-	*(plaintext+6) = *(ciphertext+6) ^ *(roundkeys+6);
-	*(plaintext+7) = *(ciphertext+7) ^ *(roundkeys+7);
-	*(plaintext+8) = *(ciphertext+8) ^ *(roundkeys+8);
-	*(plaintext+9) = *(ciphertext+9) ^ *(roundkeys+9);
-	*(plaintext+10) = *(ciphertext+10) ^ *(roundkeys+10);
-	*(plaintext+11) = *(ciphertext+11) ^ *(roundkeys+11);
-	*(plaintext+12) = *(ciphertext+12) ^ *(roundkeys+12);
-	*(plaintext+13) = *(ciphertext+13) ^ *(roundkeys+13);
-	*(plaintext+14) = *(ciphertext+14) ^ *(roundkeys+14);
-	*(plaintext+15) = *(ciphertext+15) ^ *(roundkeys+15);
+	*(plaintext+0) = *(ciphertext+0) ^ RK(roundkeys+0);
+	*(plaintext+1) = *(ciphertext+1) ^ RK(roundkeys+1);
+	*(plaintext+2) = *(ciphertext+2) ^ RK(roundkeys+2);
+	*(plaintext+3) = *(ciphertext+3) ^ RK(roundkeys+3);
+	*(plaintext+4) = *(ciphertext+4) ^ RK(roundkeys+4);
+	*(plaintext+5) = *(ciphertext+5) ^ RK(roundkeys+5);
+	*(plaintext+6) = *(ciphertext+6) ^ RK(roundkeys+6);
+	*(plaintext+7) = *(ciphertext+7) ^ RK(roundkeys+7);
+	*(plaintext+8) = *(ciphertext+8) ^ RK(roundkeys+8);
+	*(plaintext+9) = *(ciphertext+9) ^ RK(roundkeys+9);
+	*(plaintext+10) = *(ciphertext+10) ^ RK(roundkeys+10);
+	*(plaintext+11) = *(ciphertext+11) ^ RK(roundkeys+11);
+	*(plaintext+12) = *(ciphertext+12) ^ RK(roundkeys+12);
+	*(plaintext+13) = *(ciphertext+13) ^ RK(roundkeys+13);
+	*(plaintext+14) = *(ciphertext+14) ^ RK(roundkeys+14);
+	*(plaintext+15) = *(ciphertext+15) ^ RK(roundkeys+15);
 	
     roundkeys -= 16;
     inv_shift_rows(plaintext);
@@ -144,22 +151,22 @@ void aes_decrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext,
         }
 		*(tmp+i) = *(plaintext+i) ^ *(roundkeys+i);
 		*/
-		*(tmp+0) = *(plaintext+0) ^ *(roundkeys+0);
-		*(tmp+1) = *(plaintext+1) ^ *(roundkeys+1);
-		*(tmp+2) = *(plaintext+2) ^ *(roundkeys+2);
-		*(tmp+3) = *(plaintext+3) ^ *(roundkeys+3);
-		*(tmp+4) = *(plaintext+4) ^ *(roundkeys+4);
-		*(tmp+5) = *(plaintext+5) ^ *(roundkeys+5);
-		*(tmp+6) = *(plaintext+6) ^ *(roundkeys+6);
-		*(tmp+7) = *(plaintext+7) ^ *(roundkeys+7);
-		*(tmp+8) = *(plaintext+8) ^ *(roundkeys+8);
-		*(tmp+9) = *(plaintext+9) ^ *(roundkeys+9);
-		*(tmp+10) = *(plaintext+10) ^ *(roundkeys+10);
-		*(tmp+11) = *(plaintext+11) ^ *(roundkeys+11);
-		*(tmp+12) = *(plaintext+12) ^ *(roundkeys+12);
-		*(tmp+13) = *(plaintext+13) ^ *(roundkeys+13);
-		*(tmp+14) = *(plaintext+14) ^ *(roundkeys+14);
-		*(tmp+15) = *(plaintext+15) ^ *(roundkeys+15);
+		*(tmp+0) = *(plaintext+0) ^ RK(roundkeys+0);
+		*(tmp+1) = *(plaintext+1) ^ RK(roundkeys+1);
+		*(tmp+2) = *(plaintext+2) ^ RK(roundkeys+2);
+		*(tmp+3) = *(plaintext+3) ^ RK(roundkeys+3);
+		*(tmp+4) = *(plaintext+4) ^ RK(roundkeys+4);
+		*(tmp+5) = *(plaintext+5) ^ RK(roundkeys+5);
+		*(tmp+6) = *(plaintext+6) ^ RK(roundkeys+6);
+		*(tmp+7) = *(plaintext+7) ^ RK(roundkeys+7);
+		*(tmp+8) = *(plaintext+8) ^ RK(roundkeys+8);
+		*(tmp+9) = *(plaintext+9) ^ RK(roundkeys+9);
+		*(tmp+10) = *(plaintext+10) ^ RK(roundkeys+10);
+		*(tmp+11) = *(plaintext+11) ^ RK(roundkeys+11);
+		*(tmp+12) = *(plaintext+12) ^ RK(roundkeys+12);
+		*(tmp+13) = *(plaintext+13) ^ RK(roundkeys+13);
+		*(tmp+14) = *(plaintext+14) ^ RK(roundkeys+14);
+		*(tmp+15) = *(plaintext+15) ^ RK(roundkeys+15);
         
         /*
          * Inverse MixColumns
@@ -278,21 +285,31 @@ void aes_decrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext,
         *(plaintext+i) ^= *(roundkeys+i);
     }
 	*/
-	*(plaintext+0) ^= *(roundkeys+0);
-	*(plaintext+1) ^= *(roundkeys+1);
-	*(plaintext+2) ^= *(roundkeys+2);
-	*(plaintext+3) ^= *(roundkeys+3);
-	*(plaintext+4) ^= *(roundkeys+4);
-	*(plaintext+5) ^= *(roundkeys+5);
-	*(plaintext+6) ^= *(roundkeys+6);
-	*(plaintext+7) ^= *(roundkeys+7);
-	*(plaintext+8) ^= *(roundkeys+8);
-	*(plaintext+9) ^= *(roundkeys+9);
-	*(plaintext+10) ^= *(roundkeys+10);
-	*(plaintext+11) ^= *(roundkeys+11);
-	*(plaintext+12) ^= *(roundkeys+12);
-	*(plaintext+13) ^= *(roundkeys+13);
-	*(plaintext+14) ^= *(roundkeys+14);
-	*(plaintext+15) ^= *(roundkeys+15);
+	*(plaintext+0) ^= RK(roundkeys+0);
+	*(plaintext+1) ^= RK(roundkeys+1);
+	*(plaintext+2) ^= RK(roundkeys+2);
+	*(plaintext+3) ^= RK(roundkeys+3);
+	*(plaintext+4) ^= RK(roundkeys+4);
+	*(plaintext+5) ^= RK(roundkeys+5);
+	*(plaintext+6) ^= RK(roundkeys+6);
+	*(plaintext+7) ^= RK(roundkeys+7);
+	*(plaintext+8) ^= RK(roundkeys+8);
+	*(plaintext+9) ^= RK(roundkeys+9);
+	*(plaintext+10) ^= RK(roundkeys+10);
+	*(plaintext+11) ^= RK(roundkeys+11);
+	*(plaintext+12) ^= RK(roundkeys+12);
+	*(plaintext+13) ^= RK(roundkeys+13);
+	*(plaintext+14) ^= RK(roundkeys+14);
+	*(plaintext+15) ^= RK(roundkeys+15);
+
+}
 
+void aes_decrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext, register uint8_t *plaintext)
+{
+	decrypt_128(roundkeys, ciphertext, plaintext, 0);
+}
+
+void aes_decrypt_128_P( register const uint8_t *roundkeys, register uint8_t *ciphertext, register uint8_t *plaintext)
+{
+	decrypt_128(roundkeys, ciphertext, plaintext, 1);
 }
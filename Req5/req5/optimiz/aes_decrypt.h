@@ -26,4 +26,9 @@
  * @par[out]plaintext:  plain text
  */
 void aes_decrypt_128(register uint8_t *roundkeys, register uint8_t *ciphertext, register uint8_t *plaintext);
+/**
+ * @purpose:            Same as aes_decrypt_128, with the round keys read from flash
+ * @par[in]roundkeys:   round keys in PROGMEM, e.g. roundkeys_P from aes_roundkeys.c
+ */
+void aes_decrypt_128_P(register const uint8_t *roundkeys, register uint8_t *ciphertext, register uint8_t *plaintext);
 #endif
@@ -14,6 +14,7 @@
 #include <stdint.h>
 
 #include "aes_encrypt.h"
+#include "aes_roundkeys.h"
 /*
  * Sbox
  */
@@ -45,7 +46,7 @@ uint8_t SBOX[256] = {
  */
 static inline uint8_t mul2(register uint8_t a)
 {
-    return (a&0x80) ? ((a<<1)^0x1b) : (a<<1);
+    return (uint8_t)((a << 1) ^ (-(a >> 7) & 0x1b));
 }
 /**
  * @purpose:    ShiftRows
@@ -79,7 +80,14 @@ static void shift_rows(register uint8_t *state)
     *(state+3)  = temp;
 }
 
-void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
+/*
+ * Round key byte from RAM, or from flash for aes_encrypt_128_P. flash is a
+ * constant in both wrappers, so each keeps only one kind of load.
+ */
+#define RK(p)   (flash ? pgm_read_byte(p) : *(p))
+
+static inline __attribute__((always_inline)) void encrypt_128( register const uint8_t *roundkeys, register uint8_t *ciphertext,
+                                                               const uint8_t flash)
 {
 
     uint8_t tmp[16], t;
@@ -94,22 +102,22 @@ void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
     }
 	*(ciphertext+i) = plaintext[i] ^ *roundkeys++;
 	*/
-	*(ciphertext+0) = plaintext[0] ^ *roundkeys++;
-	*(ciphertext+1) = plaintext[1] ^ *roundkeys++;
-	*(ciphertext+2) = plaintext[2] ^ *roundkeys++;
-	*(ciphertext+3) = plaintext[3] ^ *roundkeys++;
-	*(ciphertext+4) = plaintext[4] ^ *roundkeys++;
-	*(ciphertext+5) = plaintext[5] ^ *roundkeys++;
-	*(ciphertext+6) = plaintext[6] ^ *roundkeys++;
-	*(ciphertext+7) = plaintext[7] ^ *roundkeys++;
-	*(ciphertext+8) = plaintext[8] ^ *roundkeys++;
-	*(ciphertext+9) = plaintext[9] ^ *roundkeys++;
-	*(ciphertext+10) = plaintext[10] ^ *roundkeys++;
-	*(ciphertext+11) = plaintext[11] ^ *roundkeys++;
-	*(ciphertext+12) = plaintext[12] ^ *roundkeys++;
-	*(ciphertext+13) = plaintext[13] ^ *roundkeys++;
-	*(ciphertext+14) = plaintext[14] ^ *roundkeys++;
-	*(ciphertext+15) = plaintext[15] ^ *roundkeys++;
+	*(ciphertext+0) = plaintext[0] ^ RK(roundkeys++);
+	*(ciphertext+1) = plaintext[1] ^ RK(roundkeys++);
+	*(ciphertext+2) = plaintext[2] ^ RK(roundkeys++);
+	*(ciphertext+3) = plaintext[3] ^ RK(roundkeys++);
+	*(ciphertext+4) = plaintext[4] ^ RK(roundkeys++);
+	*(ciphertext+5) = plaintext[5] ^ RK(roundkeys++);
+	*(ciphertext+6) = plaintext[6] ^ RK(roundkeys++);
+	*(ciphertext+7) = plaintext[7] ^ RK(roundkeys++);
+	*(ciphertext+8) = plaintext[8] ^ RK(roundkeys++);
+	*(ciphertext+9) = plaintext[9] ^ RK(roundkeys++);
+	*(ciphertext+10) = plaintext[10] ^ RK(roundkeys++);
+	*(ciphertext+11) = plaintext[11] ^ RK(roundkeys++);
+	*(ciphertext+12) = plaintext[12] ^ RK(roundkeys++);
+	*(ciphertext+13) = plaintext[13] ^ RK(roundkeys++);
+	*(ciphertext+14) = plaintext[14] ^ RK(roundkeys++);
+	*(ciphertext+15) = plaintext[15] ^ RK(roundkeys++);
 
     // 9 rounds
     /*
@@ -260,22 +268,22 @@ void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
         ciphertext[14] = mul2(tmp[14] ^ tmp[15]) ^ tmp[14] ^ t;
         ciphertext[15] = mul2(tmp[15] ^ tmp[12]  ) ^ tmp[15] ^ t;
 		
-		*(ciphertext+0) ^= *roundkeys++;
-		*(ciphertext+1) ^= *roundkeys++;
-		*(ciphertext+2) ^= *roundkeys++;
-		*(ciphertext+3) ^= *roundkeys++;
-		*(ciphertext+4) ^= *roundkeys++;
-		*(ciphertext+5) ^= *roundkeys++;
-		*(ciphertext+6) ^= *roundkeys++;
-		*(ciphertext+7) ^= *roundkeys++;
-		*(ciphertext+8) ^= *roundkeys++;
-		*(ciphertext+9) ^= *roundkeys++;
-		*(ciphertext+10) ^= *roundkeys++;
-		*(ciphertext+11) ^= *roundkeys++;
-		*(ciphertext+12) ^= *roundkeys++;
-		*(ciphertext+13) ^= *roundkeys++;
-		*(ciphertext+14) ^= *roundkeys++;
-		*(ciphertext+15) ^= *roundkeys++;
+		*(ciphertext+0) ^= RK(roundkeys++);
+		*(ciphertext+1) ^= RK(roundkeys++);
+		*(ciphertext+2) ^= RK(roundkeys++);
+		*(ciphertext+3) ^= RK(roundkeys++);
+		*(ciphertext+4) ^= RK(roundkeys++);
+		*(ciphertext+5) ^= RK(roundkeys++);
+		*(ciphertext+6) ^= RK(roundkeys++);
+		*(ciphertext+7) ^= RK(roundkeys++);
+		*(ciphertext+8) ^= RK(roundkeys++);
+		*(ciphertext+9) ^= RK(roundkeys++);
+		*(ciphertext+10) ^= RK(roundkeys++);
+		*(ciphertext+11) ^= RK(roundkeys++);
+		*(ciphertext+12) ^= RK(roundkeys++);
+		*(ciphertext+13) ^= RK(roundkeys++);
+		*(ciphertext+14) ^= RK(roundkeys++);
+		*(ciphertext+15) ^= RK(roundkeys++);
 		
 		*(tmp+0) = SBOX[*(ciphertext+0)];
 		*(tmp+1) = SBOX[*(ciphertext+1)];
@@ -319,22 +327,22 @@ void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
         ciphertext[14] = mul2(tmp[14] ^ tmp[15]) ^ tmp[14] ^ t;
         ciphertext[15] = mul2(tmp[15] ^ tmp[12]  ) ^ tmp[15] ^ t;
 		
-		*(ciphertext+0) ^= *roundkeys++;
-		*(ciphertext+1) ^= *roundkeys++;
-		*(ciphertext+2) ^= *roundkeys++;
-		*(ciphertext+3) ^= *roundkeys++;
-		*(ciphertext+4) ^= *roundkeys++;
-		*(ciphertext+5) ^= *roundkeys++;
-		*(ciphertext+6) ^= *roundkeys++;
-		*(ciphertext+7) ^= *roundkeys++;
-		*(ciphertext+8) ^= *roundkeys++;
-		*(ciphertext+9) ^= *roundkeys++;
-		*(ciphertext+10) ^= *roundkeys++;
-		*(ciphertext+11) ^= *roundkeys++;
-		*(ciphertext+12) ^= *roundkeys++;
-		*(ciphertext+13) ^= *roundkeys++;
-		*(ciphertext+14) ^= *roundkeys++;
-		*(ciphertext+15) ^= *roundkeys++;
+		*(ciphertext+0) ^= RK(roundkeys++);
+		*(ciphertext+1) ^= RK(roundkeys++);
+		*(ciphertext+2) ^= RK(roundkeys++);
+		*(ciphertext+3) ^= RK(roundkeys++);
+		*(ciphertext+4) ^= RK(roundkeys++);
+		*(ciphertext+5) ^= RK(roundkeys++);
+		*(ciphertext+6) ^= RK(roundkeys++);
+		*(ciphertext+7) ^= RK(roundkeys++);
+		*(ciphertext+8) ^= RK(roundkeys++);
+		*(ciphertext+9) ^= RK(roundkeys++);
+		*(ciphertext+10) ^= RK(roundkeys++);
+		*(ciphertext+11) ^= RK(roundkeys++);
+		*(ciphertext+12) ^= RK(roundkeys++);
+		*(ciphertext+13) ^= RK(roundkeys++);
+		*(ciphertext+14) ^= RK(roundkeys++);
+		*(ciphertext+15) ^= RK(roundkeys++);
 		
 		*(tmp+0) = SBOX[*(ciphertext+0)];
 		*(tmp+1) = SBOX[*(ciphertext+1)];
@@ -378,22 +386,22 @@ void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
         ciphertext[14] = mul2(tmp[14] ^ tmp[15]) ^ tmp[14] ^ t;
         ciphertext[15] = mul2(tmp[15] ^ tmp[12]  ) ^ tmp[15] ^ t;
 		
-		*(ciphertext+0) ^= *roundkeys++;
-		*(ciphertext+1) ^= *roundkeys++;
-		*(ciphertext+2) ^= *roundkeys++;
-		*(ciphertext+3) ^= *roundkeys++;
-		*(ciphertext+4) ^= *roundkeys++;
-		*(ciphertext+5) ^= *roundkeys++;
-		*(ciphertext+6) ^= *roundkeys++;
-		*(ciphertext+7) ^= *roundkeys++;
-		*(ciphertext+8) ^= *roundkeys++;
-		*(ciphertext+9) ^= *roundkeys++;
-		*(ciphertext+10) ^= *roundkeys++;
-		*(ciphertext+11) ^= *roundkeys++;
-		*(ciphertext+12) ^= *roundkeys++;
-		*(ciphertext+13) ^= *roundkeys++;
-		*(ciphertext+14) ^= *roundkeys++;
-		*(ciphertext+15) ^= *roundkeys++;
+		*(ciphertext+0) ^= RK(roundkeys++);
+		*(ciphertext+1) ^= RK(roundkeys++);
+		*(ciphertext+2) ^= RK(roundkeys++);
+		*(ciphertext+3) ^= RK(roundkeys++);
+		*(ciphertext+4) ^= RK(roundkeys++);
+		*(ciphertext+5) ^= RK(roundkeys++);
+		*(ciphertext+6) ^= RK(roundkeys++);
+		*(ciphertext+7) ^= RK(roundkeys++);
+		*(ciphertext+8) ^= RK(roundkeys++);
+		*(ciphertext+9) ^= RK(roundkeys++);
+		*(ciphertext+10) ^= RK(roundkeys++);
+		*(ciphertext+11) ^= RK(roundkeys++);
+		*(ciphertext+12) ^= RK(roundkeys++);
+		*(ciphertext+13) ^= RK(roundkeys++);
+		*(ciphertext+14) ^= RK(roundkeys++);
+		*(ciphertext+15) ^= RK(roundkeys++);
 		
 		*(tmp+0) = SBOX[*(ciphertext+0)];
 		*(tmp+1) = SBOX[*(ciphertext+1)];
@@ -437,22 +445,22 @@ void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
         ciphertext[14] = mul2(tmp[14] ^ tmp[15]) ^ tmp[14] ^ t;
         ciphertext[15] = mul2(tmp[15] ^ tmp[12]  ) ^ tmp[15] ^ t;
 		
-		*(ciphertext+0) ^= *roundkeys++;
-		*(ciphertext+1) ^= *roundkeys++;
-		*(ciphertext+2) ^= *roundkeys++;
-		*(ciphertext+3) ^= *roundkeys++;
-		*(ciphertext+4) ^= *roundkeys++;
-		*(ciphertext+5) ^= *roundkeys++;
-		*(ciphertext+6) ^= *roundkeys++;
-		*(ciphertext+7) ^= *roundkeys++;
-		*(ciphertext+8) ^= *roundkeys++;
-		*(ciphertext+9) ^= *roundkeys++;
-		*(ciphertext+10) ^= *roundkeys++;
-		*(ciphertext+11) ^= *roundkeys++;
-		*(ciphertext+12) ^= *roundkeys++;
-		*(ciphertext+13) ^= *roundkeys++;
-		*(ciphertext+14) ^= *roundkeys++;
-		*(ciphertext+15) ^= *roundkeys++;
+		*(ciphertext+0) ^= RK(roundkeys++);
+		*(ciphertext+1) ^= RK(roundkeys++);
+		*(ciphertext+2) ^= RK(roundkeys++);
+		*(ciphertext+3) ^= RK(roundkeys++);
+		*(ciphertext+4) ^= RK(roundkeys++);
+		*(ciphertext+5) ^= RK(roundkeys++);
+		*(ciphertext+6) ^= RK(roundkeys++);
+		*(ciphertext+7) ^= RK(roundkeys++);
+		*(ciphertext+8) ^= RK(roundkeys++);
+		*(ciphertext+9) ^= RK(roundkeys++);
+		*(ciphertext+10) ^= RK(roundkeys++);
+		*(ciphertext+11) ^= RK(roundkeys++);
+		*(ciphertext+12) ^= RK(roundkeys++);
+		*(ciphertext+13) ^= RK(roundkeys++);
+		*(ciphertext+14) ^= RK(roundkeys++);
+		*(ciphertext+15) ^= RK(roundkeys++);
 		
 		*(tmp+0) = SBOX[*(ciphertext+0)];
 		*(tmp+1) = SBOX[*(ciphertext+1)];
@@ -496,22 +504,22 @@ void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
         ciphertext[14] = mul2(tmp[14] ^ tmp[15]) ^ tmp[14] ^ t;
         ciphertext[15] = mul2(tmp[15] ^ tmp[12]  ) ^ tmp[15] ^ t;
 		
-		*(ciphertext+0) ^= *roundkeys++;
-		*(ciphertext+1) ^= *roundkeys++;
-		*(ciphertext+2) ^= *roundkeys++;
-		*(ciphertext+3) ^= *roundkeys++;
-		*(ciphertext+4) ^= *roundkeys++;
-		*(ciphertext+5) ^= *roundkeys++;
-		*(ciphertext+6) ^= *roundkeys++;
-		*(ciphertext+7) ^= *roundkeys++;
-		*(ciphertext+8) ^= *roundkeys++;
-		*(ciphertext+9) ^= *roundkeys++;
-		*(ciphertext+10) ^= *roundkeys++;
-		*(ciphertext+11) ^= *roundkeys++;
-		*(ciphertext+12) ^= *roundkeys++;
-		*(ciphertext+13) ^= *roundkeys++;
-		*(ciphertext+14) ^= *roundkeys++;
-		*(ciphertext+15) ^= *roundkeys++;
+		*(ciphertext+0) ^= RK(roundkeys++);
+		*(ciphertext+1) ^= RK(roundkeys++);
+		*(ciphertext+2) ^= RK(roundkeys++);
+		*(ciphertext+3) ^= RK(roundkeys++);
+		*(ciphertext+4) ^= RK(roundkeys++);
+		*(ciphertext+5) ^= RK(roundkeys++);
+		*(ciphertext+6) ^= RK(roundkeys++);
+		*(ciphertext+7) ^= RK(roundkeys++);
+		*(ciphertext+8) ^= RK(roundkeys++);
+		*(ciphertext+9) ^= RK(roundkeys++);
+		*(ciphertext+10) ^= RK(roundkeys++);
+		*(ciphertext+11) ^= RK(roundkeys++);
+		*(ciphertext+12) ^= RK(roundkeys++);
+		*(ciphertext+13) ^= RK(roundkeys++);
+		*(ciphertext+14) ^= RK(roundkeys++);
+		*(ciphertext+15) ^= RK(roundkeys++);
 		
 		*(tmp+0) = SBOX[*(ciphertext+0)];
 		*(tmp+1) = SBOX[*(ciphertext+1)];
@@ -555,22 +563,22 @@ void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
         ciphertext[14] = mul2(tmp[14] ^ tmp[15]) ^ tmp[14] ^ t;
         ciphertext[15] = mul2(tmp[15] ^ tmp[12]  ) ^ tmp[15] ^ t;
 		
-		*(ciphertext+0) ^= *roundkeys++;
-		*(ciphertext+1) ^= *roundkeys++;
-		*(ciphertext+2) ^= *roundkeys++;
-		*(ciphertext+3) ^= *roundkeys++;
-		*(ciphertext+4) ^= *roundkeys++;
-		*(ciphertext+5) ^= *roundkeys++;
-		*(ciphertext+6) ^= *roundkeys++;
-		*(ciphertext+7) ^= *roundkeys++;
-		*(ciphertext+8) ^= *roundkeys++;
-		*(ciphertext+9) ^= *roundkeys++;
-		*(ciphertext+10) ^= *roundkeys++;
-		*(ciphertext+11) ^= *roundkeys++;
-		*(ciphertext+12) ^= *roundkeys++;
-		*(ciphertext+13) ^= *roundkeys++;
-		*(ciphertext+14) ^= *roundkeys++;
-		*(ciphertext+15) ^= *roundkeys++;
+		*(ciphertext+0) ^= RK(roundkeys++);
+		*(ciphertext+1) ^= RK(roundkeys++);
+		*(ciphertext+2) ^= RK(roundkeys++);
+		*(ciphertext+3) ^= RK(roundkeys++);
+		*(ciphertext+4) ^= RK(roundkeys++);
+		*(ciphertext+5) ^= RK(roundkeys++);
+		*(ciphertext+6) ^= RK(roundkeys++);
+		*(ciphertext+7) ^= RK(roundkeys++);
+		*(ciphertext+8) ^= RK(roundkeys++);
+		*(ciphertext+9) ^= RK(roundkeys++);
+		*(ciphertext+10) ^= RK(roundkeys++);
+		*(ciphertext+11) ^= RK(roundkeys++);
+		*(ciphertext+12) ^= RK(roundkeys++);
+		*(ciphertext+13) ^= RK(roundkeys++);
+		*(ciphertext+14) ^= RK(roundkeys++);
+		*(ciphertext+15) ^= RK(roundkeys++);
 		
 		*(tmp+0) = SBOX[*(ciphertext+0)];
 		*(tmp+1) = SBOX[*(ciphertext+1)];
@@ -614,22 +622,22 @@ void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
         ciphertext[14] = mul2(tmp[14] ^ tmp[15]) ^ tmp[14] ^ t;
         ciphertext[15] = mul2(tmp[15] ^ tmp[12]  ) ^ tmp[15] ^ t;
 		
-		*(ciphertext+0) ^= *roundkeys++;
-		*(ciphertext+1) ^= *roundkeys++;
-		*(ciphertext+2) ^= *roundkeys++;
-		*(ciphertext+3) ^= *roundkeys++;
-		*(ciphertext+4) ^= *roundkeys++;
-		*(ciphertext+5) ^= *roundkeys++;
-		*(ciphertext+6) ^= *roundkeys++;
-		*(ciphertext+7) ^= *roundkeys++;
-		*(ciphertext+8) ^= *roundkeys++;
-		*(ciphertext+9) ^= *roundkeys++;
-		*(ciphertext+10) ^= *roundkeys++;
-		*(ciphertext+11) ^= *roundkeys++;
-		*(ciphertext+12) ^= *roundkeys++;
-		*(ciphertext+13) ^= *roundkeys++;
-		*(ciphertext+14) ^= *roundkeys++;
-		*(ciphertext+15) ^= *roundkeys++;
+		*(ciphertext+0) ^= RK(roundkeys++);
+		*(ciphertext+1) ^= RK(roundkeys++);
+		*(ciphertext+2) ^= RK(roundkeys++);
+		*(ciphertext+3) ^= RK(roundkeys++);
+		*(ciphertext+4) ^= RK(roundkeys++);
+		*(ciphertext+5) ^= RK(roundkeys++);
+		*(ciphertext+6) ^= RK(roundkeys++);
+		*(ciphertext+7) ^= RK(roundkeys++);
+		*(ciphertext+8) ^= RK(roundkeys++);
+		*(ciphertext+9) ^= RK(roundkeys++);
+		*(ciphertext+10) ^= RK(roundkeys++);
+		*(ciphertext+11) ^= RK(roundkeys++);
+		*(ciphertext+12) ^= RK(roundkeys++);
+		*(ciphertext+13) ^= RK(roundkeys++);
+		*(ciphertext+14) ^= RK(roundkeys++);
+		*(ciphertext+15) ^= RK(roundkeys++);
 		
 		*(tmp+0) = SBOX[*(ciphertext+0)];
 		*(tmp+1) = SBOX[*(ciphertext+1)];
@@ -673,22 +681,22 @@ void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
         ciphertext[14] = mul2(tmp[14] ^ tmp[15]) ^ tmp[14] ^ t;
         ciphertext[15] = mul2(tmp[15] ^ tmp[12]  ) ^ tmp[15] ^ t;
 		
-		*(ciphertext+0) ^= *roundkeys++;
-		*(ciphertext+1) ^= *roundkeys++;
-		*(ciphertext+2) ^= *roundkeys++;
-		*(ciphertext+3) ^= *roundkeys++;
-		*(ciphertext+4) ^= *roundkeys++;
-		*(ciphertext+5) ^= *roundkeys++;
-		*(ciphertext+6) ^= *roundkeys++;
-		*(ciphertext+7) ^= *roundkeys++;
-		*(ciphertext+8) ^= *roundkeys++;
-		*(ciphertext+9) ^= *roundkeys++;
-		*(ciphertext+10) ^= *roundkeys++;
-		*(ciphertext+11) ^= *roundkeys++;
-		*(ciphertext+12) ^= *roundkeys++;
-		*(ciphertext+13) ^= *roundkeys++;
-		*(ciphertext+14) ^= *roundkeys++;
-		*(ciphertext+15) ^= *roundkeys++;
+		*(ciphertext+0) ^= RK(roundkeys++);
+		*(ciphertext+1) ^= RK(roundkeys++);
+		*(ciphertext+2) ^= RK(roundkeys++);
+		*(ciphertext+3) ^= RK(roundkeys++);
+		*(ciphertext+4) ^= RK(roundkeys++);
+		*(ciphertext+5) ^= RK(roundkeys++);
+		*(ciphertext+6) ^= RK(roundkeys++);
+		*(ciphertext+7) ^= RK(roundkeys++);
+		*(ciphertext+8) ^= RK(roundkeys++);
+		*(ciphertext+9) ^= RK(roundkeys++);
+		*(ciphertext+10) ^= RK(roundkeys++);
+		*(ciphertext+11) ^= RK(roundkeys++);
+		*(ciphertext+12) ^= RK(roundkeys++);
+		*(ciphertext+13) ^= RK(roundkeys++);
+		*(ciphertext+14) ^= RK(roundkeys++);
+		*(ciphertext+15) ^= RK(roundkeys++);
 		
 		*(tmp+0) = SBOX[*(ciphertext+0)];
 		*(tmp+1) = SBOX[*(ciphertext+1)];
@@ -732,22 +740,22 @@ void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
         ciphertext[14] = mul2(tmp[14] ^ tmp[15]) ^ tmp[14] ^ t;
         ciphertext[15] = mul2(tmp[15] ^ tmp[12]  ) ^ tmp[15] ^ t;
 		
-		*(ciphertext+0) ^= *roundkeys++;
-		*(ciphertext+1) ^= *roundkeys++;
-		*(ciphertext+2) ^= *roundkeys++;
-		*(ciphertext+3) ^= *roundkeys++;
-		*(ciphertext+4) ^= *roundkeys++;
-		*(ciphertext+5) ^= *roundkeys++;
-		*(ciphertext+6) ^= *roundkeys++;
-		*(ciphertext+7) ^= *roundkeys++;
-		*(ciphertext+8) ^= *roundkeys++;
-		*(ciphertext+9) ^= *roundkeys++;
-		*(ciphertext+10) ^= *roundkeys++;
-		*(ciphertext+11) ^= *roundkeys++;
-		*(ciphertext+12) ^= *roundkeys++;
-		*(ciphertext+13) ^= *roundkeys++;
-		*(ciphertext+14) ^= *roundkeys++;
-		*(ciphertext+15) ^= *roundkeys++;
+		*(ciphertext+0) ^= RK(roundkeys++);
+		*(ciphertext+1) ^= RK(roundkeys++);
+		*(ciphertext+2) ^= RK(roundkeys++);
+		*(ciphertext+3) ^= RK(roundkeys++);
+		*(ciphertext+4) ^= RK(roundkeys++);
+		*(ciphertext+5) ^= RK(roundkeys++);
+		*(ciphertext+6) ^= RK(roundkeys++);
+		*(ciphertext+7) ^= RK(roundkeys++);
+		*(ciphertext+8) ^= RK(roundkeys++);
+		*(ciphertext+9) ^= RK(roundkeys++);
+		*(ciphertext+10) ^= RK(roundkeys++);
+		*(ciphertext+11) ^= RK(roundkeys++);
+		*(ciphertext+12) ^= RK(roundkeys++);
+		*(ciphertext+13) ^= RK(roundkeys++);
+		*(ciphertext+14) ^= RK(roundkeys++);
+		*(ciphertext+15) ^= RK(roundkeys++);
 		
     
     // last round
@@ -783,20 +791,30 @@ void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
     }
 	*(ciphertext+i) ^= *roundkeys++;
 	*/
-	*(ciphertext+0) ^= *roundkeys++;
-	*(ciphertext+1) ^= *roundkeys++;
-	*(ciphertext+2) ^= *roundkeys++;
-	*(ciphertext+3) ^= *roundkeys++;
-	*(ciphertext+4) ^= *roundkeys++;
-	*(ciphertext+5) ^= *roundkeys++;
-	*(ciphertext+6) ^= *roundkeys++;
-	*(ciphertext+7) ^= *roundkeys++;
-	*(ciphertext+8) ^= *roundkeys++;
-	*(ciphertext+9) ^= *roundkeys++;
-	*(ciphertext+10) ^= *roundkeys++;
-	*(ciphertext+11) ^= *roundkeys++;
-	*(ciphertext+12) ^= *roundkeys++;
-	*(ciphertext+13) ^= *roundkeys++;
-	*(ciphertext+14) ^= *roundkeys++;
-	*(ciphertext+15) ^= *roundkeys++;
+	*(ciphertext+0) ^= RK(roundkeys++);
+	*(ciphertext+1) ^= RK(roundkeys++);
+	*(ciphertext+2) ^= RK(roundkeys++);
+	*(ciphertext+3) ^= RK(roundkeys++);
+	*(ciphertext+4) ^= RK(roundkeys++);
+	*(ciphertext+5) ^= RK(roundkeys++);
+	*(ciphertext+6) ^= RK(roundkeys++);
+	*(ciphertext+7) ^= RK(roundkeys++);
+	*(ciphertext+8) ^= RK(roundkeys++);
+	*(ciphertext+9) ^= RK(roundkeys++);
+	*(ciphertext+10) ^= RK(roundkeys++);
+	*(ciphertext+11) ^= RK(roundkeys++);
+	*(ciphertext+12) ^= RK(roundkeys++);
+	*(ciphertext+13) ^= RK(roundkeys++);
+	*(ciphertext+14) ^= RK(roundkeys++);
+	*(ciphertext+15) ^= RK(roundkeys++);
+}
+
+void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext)
+{
+	encrypt_128(roundkeys, ciphertext, 0);
+}
+
+void aes_encrypt_128_P( register const uint8_t *roundkeys, register uint8_t *ciphertext)
+{
+	encrypt_128(roundkeys, ciphertext, 1);
 }
@@ -29,5 +29,10 @@ extern uint8_t SBOX[256];
 
 extern uint8_t plaintext[];
 void aes_encrypt_128( register uint8_t *roundkeys, register uint8_t *ciphertext);
+/**
+ * @purpose:            Same as aes_encrypt_128, with the round keys read from flash
+ * @par[in]roundkeys:   round keys in PROGMEM, e.g. roundkeys_P from aes_roundkeys.c
+ */
+void aes_encrypt_128_P( register const uint8_t *roundkeys, register uint8_t *ciphertext);
 
 #endif
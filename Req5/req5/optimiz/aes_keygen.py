@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""
+aes_keygen.py
+
+Build-time AES-128 key expansion for devices with a fixed key. Writes the
+176 bytes of round keys to aes_roundkeys.c as roundkeys_P in PROGMEM, so
+the firmware neither runs aes_key_schedule_128 nor keeps the schedule in
+SRAM (see aes_roundkeys.h).
+
+  python3 aes_keygen.py                         # key[] from main.c
+  python3 aes_keygen.py --key 000102...0e0f     # provisioned key
+  python3 aes_keygen.py --key ... -o build/aes_roundkeys.c
+
+The expansion is checked against FIPS-197 A.1 before anything is written.
+"""
+import argparse
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def gf_mul(a, b):
+    p = 0
+    for _ in range(8):
+        if b & 1:
+            p ^= a
+        a = ((a << 1) ^ (0x1b if a & 0x80 else 0)) & 0xff
+        b >>= 1
+    return p
+
+
+def sbox(x):
+    # inverse as x^254, then the affine transform
+    inv = 1
+    for _ in range(254):
+        inv = gf_mul(inv, x)
+    s = inv
+    for k in range(1, 5):
+        s ^= ((inv << k) | (inv >> (8 - k))) & 0xff
+    return s ^ 0x63
+
+
+SBOX = [sbox(x) for x in range(256)]
+
+
+def expand(key):
+    """FIPS-197 5.2 for Nk = 4, 11 round keys of 16 bytes"""
+    rk = list(key)
+    rc = 1
+    for i in range(4, 44):
+        t = rk[-4:]
+        if i % 4 == 0:
+            t = [SBOX[b] for b in t[1:] + t[:1]]
+            t[0] ^= rc
+            rc = gf_mul(rc, 2)
+        rk += [a ^ b for a, b in zip(rk[-16:-12], t)]
+    return rk
+
+
+def key_from_main(path):
+    src = open(path).read()
+    m = re.search(r"const\s+uint8_t\s+key\s*\[\s*\]\s*=\s*\{(.*?)\};", src, re.S)
+    if not m:
+        sys.exit("%s: no const uint8_t key[] initializer" % path)
+    body = re.sub(r"//[^\n]*|/\*.*?\*/", "", m.group(1), flags=re.S)
+    return [int(b, 16) for b in re.findall(r"0x[0-9a-fA-F]{1,2}", body)]
+
+
+def emit(rk, path):
+    lines = [
+        "/*",
+        " * aes_roundkeys.c",
+        " *",
+        " * Generated by aes_keygen.py, do not edit. AES-128 round keys of the",
+        " * device key for aes_encrypt_128_P and aes_decrypt_128_P.",
+        " *",
+        " */",
+        "#include <stdint.h>",
+        '#include "aes_roundkeys.h"',
+        "",
+        "#if AES_ROUNDKEYS_FLASH",
+        "const uint8_t roundkeys_P[AES_ROUND_KEY_SIZE] PROGMEM = {",
+    ]
+    for r in range(11):
+        row = ", ".join("0x%02x" % b for b in rk[16 * r:16 * r + 16])
+        lines.append("\t%s,\t// round %d" % (row, r))
+    lines += ["};", "#endif", ""]
+    # the project sources are CRLF
+    with open(path, "w", newline="\r\n") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    ap.add_argument("--key", help="16-byte key as 32 hex digits (default: key[] in main.c)")
+    ap.add_argument("--main", default=os.path.join(HERE, "main.c"), help="source holding key[]")
+    ap.add_argument("-o", "--output", default=os.path.join(HERE, "aes_roundkeys.c"))
+    args = ap.parse_args()
+
+    fips = expand(range(16))
+    if bytes(fips[160:]).hex() != "13111d7fe3944a17f307a78b4d2b30c5":
+        sys.exit("key expansion does not match FIPS-197 A.1")
+
+    if args.key:
+        try:
+            key = list(bytes.fromhex(args.key))
+        except ValueError:
+            sys.exit("--key: not a hex string")
+    else:
+        key = key_from_main(args.main)
+    if len(key) != 16:
+        sys.exit("need a 16-byte key, got %d bytes" % len(key))
+
+    emit(expand(key), args.output)
+    print("wrote %s" % args.output)
+
+
+if __name__ == "__main__":
+    main()
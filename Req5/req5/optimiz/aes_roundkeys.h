@@ -0,0 +1,35 @@
+/*
+ * aes_roundkeys.h
+ *
+ * Round keys of the device key, expanded at build time into flash.
+ * aes_keygen.py writes them to aes_roundkeys.c from key[] in main.c, or from
+ * a provisioned key given on its command line. Rerun it whenever the key
+ * changes.
+ *
+ * With AES_ROUNDKEYS_FLASH set (the default), main.c encrypts and decrypts
+ * with aes_encrypt_128_P/aes_decrypt_128_P straight from roundkeys_P, and
+ * aes_key_schedule_128 and the 176-byte RAM schedule are not built.
+ * Define it to 0 to expand key[] at run time instead.
+ *
+ */
+#ifndef AES_ROUNDKEYS_H
+#define AES_ROUNDKEYS_H
+#include <stdint.h>
+#include "aes_schedule.h"
+
+#ifndef AES_ROUNDKEYS_FLASH
+#define AES_ROUNDKEYS_FLASH     1
+#endif
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_byte(p)        (*(const uint8_t *)(p))
+#endif
+
+#if AES_ROUNDKEYS_FLASH
+extern const uint8_t roundkeys_P[AES_ROUND_KEY_SIZE] PROGMEM;
+#endif
+
+#endif
@@ -16,6 +16,9 @@
 
 #include "aes_schedule.h"
 #include "aes_encrypt.h"
+#include "aes_roundkeys.h"
+
+#if !AES_ROUNDKEYS_FLASH
 /*
  * round constants
  */
@@ -59,7 +62,7 @@ void aes_key_schedule_128( register uint8_t *roundkeys)
         temp[0] = SBOX[*last4bytes++];
         temp[1] = SBOX[*last4bytes++];
         temp[2] = SBOX[*last4bytes++];
-        temp[0] ^= RC[i];
+        temp[0] ^= RC[AES_ROUNDS - i];   // i counts down from AES_ROUNDS
         lastround = roundkeys-16;
         *roundkeys++ = temp[0] ^ *lastround++;
         *roundkeys++ = temp[1] ^ *lastround++;
@@ -82,3 +85,4 @@ void aes_key_schedule_128( register uint8_t *roundkeys)
         *roundkeys++ = *last4bytes++ ^ *lastround++;
     }
 }
+#endif
@@ -17,8 +17,10 @@
 #include "aes_decrypt.h"
 #include "aes_encrypt.h"
 #include "aes_schedule.h"
+#include "aes_roundkeys.h"
 
-	/* 128 bit key */
+	/* 128 bit key, expanded at build time into aes_roundkeys.c by aes_keygen.py */
+#if !AES_ROUNDKEYS_FLASH
 	const uint8_t key[] = {
 		//0x0f, 0x15, 0x71, 0xc9, 0x47, 0xd9, 0xe8, 0x59,
 		//0x0c, 0xb7, 0xad, 0xd6, 0xaf, 0x7f, 0x67, 0x98,
@@ -26,6 +28,7 @@
 		0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
 
 	};
+#endif
 	
 	uint8_t plaintext[] = {
 		//0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
@@ -49,6 +52,10 @@ int main() {
 		0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a,
 	};
 	
+#if AES_ROUNDKEYS_FLASH
+	// encryption, round keys from flash
+	aes_encrypt_128_P(roundkeys_P, ciphertext);
+#else
 	uint8_t roundkeys[AES_ROUND_KEY_SIZE];
 
 	// key schedule
@@ -56,6 +63,7 @@ int main() {
 
 	// encryption
 	aes_encrypt_128(roundkeys, ciphertext);
+#endif
 
 	for (i = (AES_BLOCK_SIZE-1); i != 0; i--) {
 		if ( ciphertext[i] != const_cipher[i] ) { break; }
@@ -64,7 +72,11 @@ int main() {
 
 
 	// decryption
+#if AES_ROUNDKEYS_FLASH
+	aes_decrypt_128_P(roundkeys_P, ciphertext, ciphertext);
+#else
 	aes_decrypt_128(roundkeys, ciphertext, ciphertext);
+#endif
 	for (i = (AES_BLOCK_SIZE-1); i != 0; i--) {
 		if ( ciphertext[i] != plaintext[i] ) { break; }
 	}
@@ -0,0 +1,371 @@
+/*
+ * aes.hpp
+ *
+ * One AES engine for the size/speed points that Req1, Req3, Req4 and Req5
+ * carry as hand-edited copies, chosen at compile time:
+ *
+ *  aes::Aes<Rounds, Storage, Unroll, Layout>
+ *
+ *  Rounds   10, 12 or 14 (AES-128/192/256, the key is 4 * (Rounds - 6) bytes)
+ *  Storage  SboxStorage::Ram   - SBOX/INV_SBOX in RAM (Req1, Req4, Req5)
+ *           SboxStorage::Flash - in PROGMEM and read with pgm_read_byte on AVR (Req3),
+ *                                plain const tables elsewhere
+ *  Unroll   unroll factor of every round and byte loop: 1 keeps them rolled (Req4),
+ *           aes::FullUnroll unrolls them all (Req5)
+ *  Layout   StateLayout::Bytes - uint8_t[16] state, byte-wise rounds
+ *           StateLayout::Words - four uint32_t columns, SWAR MixColumns (aes_encrypt_128_word)
+ *
+ * Header only. Needs C++17 (if constexpr, inline variables) but not the
+ * C++ standard library, which avr-gcc does not ship.
+ *
+ */
+#ifndef AES_HPP
+#define AES_HPP
+#include <stdint.h>
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#endif
+
+#define AES_TPL_INLINE inline __attribute__((always_inline))
+
+namespace aes {
+
+enum class SboxStorage : uint8_t { Ram, Flash };
+enum class StateLayout : uint8_t { Bytes, Words };
+
+constexpr unsigned FullUnroll = 0xffffu;
+
+namespace detail {
+
+#define AES_TPL_SBOX \
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76, \
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0, \
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15, \
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75, \
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84, \
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf, \
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8, \
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2, \
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73, \
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb, \
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79, \
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08, \
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a, \
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e, \
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf, \
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+
+#define AES_TPL_INV_SBOX \
+    0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb, \
+    0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb, \
+    0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e, \
+    0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25, \
+    0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92, \
+    0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84, \
+    0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06, \
+    0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b, \
+    0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73, \
+    0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e, \
+    0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b, \
+    0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4, \
+    0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f, \
+    0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef, \
+    0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61, \
+    0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d
+
+template <SboxStorage Storage> struct Sbox;
+
+template <> struct Sbox<SboxStorage::Ram> {
+    static inline uint8_t fwd[256] = { AES_TPL_SBOX };
+    static inline uint8_t inv[256] = { AES_TPL_INV_SBOX };
+    static AES_TPL_INLINE uint8_t sub(uint8_t x)     { return fwd[x]; }
+    static AES_TPL_INLINE uint8_t inv_sub(uint8_t x) { return inv[x]; }
+};
+
+#if defined(__AVR__)
+template <> struct Sbox<SboxStorage::Flash> {
+    static inline const uint8_t fwd[256] __attribute__((__progmem__)) = { AES_TPL_SBOX };
+    static inline const uint8_t inv[256] __attribute__((__progmem__)) = { AES_TPL_INV_SBOX };
+    static AES_TPL_INLINE uint8_t sub(uint8_t x)     { return pgm_read_byte(fwd + x); }
+    static AES_TPL_INLINE uint8_t inv_sub(uint8_t x) { return pgm_read_byte(inv + x); }
+};
+#else
+template <> struct Sbox<SboxStorage::Flash> {
+    static inline const uint8_t fwd[256] = { AES_TPL_SBOX };
+    static inline const uint8_t inv[256] = { AES_TPL_INV_SBOX };
+    static AES_TPL_INLINE uint8_t sub(uint8_t x)     { return fwd[x]; }
+    static AES_TPL_INLINE uint8_t inv_sub(uint8_t x) { return inv[x]; }
+};
+#endif
+
+#undef AES_TPL_SBOX
+#undef AES_TPL_INV_SBOX
+
+/*
+ * Calls f(base + I), ..., f(base + N - 1) as straight-line code.
+ */
+template <unsigned I, unsigned N> struct Repeat {
+    template <typename F> static AES_TPL_INLINE void run(F &f, unsigned base) {
+        f(base + I);
+        Repeat<I + 1, N>::run(f, base);
+    }
+};
+
+template <unsigned N> struct Repeat<N, N> {
+    template <typename F> static AES_TPL_INLINE void run(F &, unsigned) {}
+};
+
+/**
+ * @purpose:    for (i = 0; i < Count; ++i) f(i), unrolled Unroll times.
+ */
+template <unsigned Unroll, unsigned Count, typename F> AES_TPL_INLINE void loop(F f) {
+    if constexpr (Unroll >= Count) {
+        Repeat<0, Count>::run(f, 0);
+    } else if constexpr (Unroll <= 1) {
+        for (unsigned i = 0; i < Count; ++i) {
+            f(i);
+        }
+    } else {
+        unsigned i = 0;
+        for (; i + Unroll <= Count; i += Unroll) {
+            Repeat<0, Unroll>::run(f, i);
+        }
+        Repeat<0, Count % Unroll>::run(f, i);
+    }
+}
+
+static AES_TPL_INLINE uint8_t mul2(uint8_t a) {
+    return (uint8_t)((a << 1) ^ ((uint8_t)-(a >> 7) & 0x1b));
+}
+
+static AES_TPL_INLINE uint32_t xtime_word(uint32_t w) {
+    return ((w & 0x7f7f7f7f) << 1) ^ (((w >> 7) & 0x01010101) * 0x1b);
+}
+
+static AES_TPL_INLINE uint32_t rotr32(uint32_t v, unsigned n) {
+    return (v >> n) | (v << (32 - n));
+}
+
+static AES_TPL_INLINE uint32_t load_word(const uint8_t *p) {
+    return (uint32_t)p[0] ^ ((uint32_t)p[1] << 8) ^ ((uint32_t)p[2] << 16) ^ ((uint32_t)p[3] << 24);
+}
+
+static AES_TPL_INLINE void store_word(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static AES_TPL_INLINE uint32_t mix_column_word(uint32_t w) {
+    uint32_t r = rotr32(w, 8);
+    uint32_t t = w ^ r;
+    return xtime_word(t) ^ r ^ rotr32(t, 16);
+}
+
+} // namespace detail
+
+template <unsigned Rounds, SboxStorage Storage, unsigned Unroll, StateLayout Layout>
+class Aes {
+
+    static_assert(Rounds == 10 || Rounds == 12 || Rounds == 14, "AES has 10, 12 or 14 rounds");
+
+    using Box = detail::Sbox<Storage>;
+
+public:
+    static constexpr unsigned rounds         = Rounds;
+    static constexpr unsigned block_size     = 16;
+    static constexpr unsigned key_size       = 4 * (Rounds - 6);
+    static constexpr unsigned round_key_size = 16 * (Rounds + 1);
+
+    /**
+     * @purpose:            Key schedule, same layout as aes_key_schedule_128 for every key size
+     * @par[in]key:         key_size bytes of master key
+     * @par[out]roundkeys:  round_key_size bytes of round keys
+     */
+    static void key_schedule(const uint8_t *key, uint8_t *roundkeys) {
+        uint8_t t0, t1, t2, t3, u, rc = 0x01;
+
+        detail::loop<Unroll, key_size>([&](unsigned i) { roundkeys[i] = key[i]; });
+        for (unsigned i = key_size; i < round_key_size; i += 4) {
+            t0 = roundkeys[i - 4];
+            t1 = roundkeys[i - 3];
+            t2 = roundkeys[i - 2];
+            t3 = roundkeys[i - 1];
+            if (i % key_size == 0) {
+                // RotWord, SubWord, Rcon
+                u  = t0;
+                t0 = Box::sub(t1) ^ rc;
+                t1 = Box::sub(t2);
+                t2 = Box::sub(t3);
+                t3 = Box::sub(u);
+                rc = detail::mul2(rc);
+            } else if (key_size == 32 && i % key_size == 16) {
+                t0 = Box::sub(t0);
+                t1 = Box::sub(t1);
+                t2 = Box::sub(t2);
+                t3 = Box::sub(t3);
+            }
+            roundkeys[i]     = roundkeys[i - key_size]     ^ t0;
+            roundkeys[i + 1] = roundkeys[i + 1 - key_size] ^ t1;
+            roundkeys[i + 2] = roundkeys[i + 2 - key_size] ^ t2;
+            roundkeys[i + 3] = roundkeys[i + 3 - key_size] ^ t3;
+        }
+    }
+
+    /**
+     * @purpose:            Encryption of one block. plaintext and ciphertext may be the same buffer
+     */
+    static void encrypt(const uint8_t *roundkeys, const uint8_t *plaintext, uint8_t *ciphertext) {
+        if constexpr (Layout == StateLayout::Words) {
+            encrypt_words(roundkeys, plaintext, ciphertext);
+        } else {
+            encrypt_bytes(roundkeys, plaintext, ciphertext);
+        }
+    }
+
+    /**
+     * @purpose:            Decryption of one block with the encryption round keys.
+     *                      ciphertext and plaintext may be the same buffer
+     */
+    static void decrypt(const uint8_t *roundkeys, const uint8_t *ciphertext, uint8_t *plaintext) {
+        if constexpr (Layout == StateLayout::Words) {
+            decrypt_words(roundkeys, ciphertext, plaintext);
+        } else {
+            decrypt_bytes(roundkeys, ciphertext, plaintext);
+        }
+    }
+
+private:
+    // source byte of ShiftRows / InvShiftRows for destination byte i = 4c + r: row r moves by r columns
+    static AES_TPL_INLINE unsigned shift(unsigned i)     { return (i + 4 * (i & 3)) & 15; }
+    static AES_TPL_INLINE unsigned inv_shift(unsigned i) { return (i - 4 * (i & 3)) & 15; }
+
+    static void encrypt_bytes(const uint8_t *roundkeys, const uint8_t *plaintext, uint8_t *ciphertext) {
+        uint8_t s[16], tmp[16];
+
+        // first AddRoundKey
+        detail::loop<Unroll, 16>([&](unsigned i) { s[i] = plaintext[i] ^ roundkeys[i]; });
+
+        // Rounds - 1 full rounds: SubBytes + ShiftRows, then MixColumns + AddRoundKey
+        detail::loop<Unroll, Rounds - 1>([&](unsigned j) {
+            const uint8_t *rk = roundkeys + 16 * (j + 1);
+            detail::loop<Unroll, 16>([&](unsigned i) { tmp[i] = Box::sub(s[shift(i)]); });
+            detail::loop<Unroll, 4>([&](unsigned c) {
+                uint8_t *a = tmp + 4 * c;
+                uint8_t t = a[0] ^ a[1] ^ a[2] ^ a[3];
+                detail::loop<Unroll, 4>([&](unsigned r) {
+                    s[4 * c + r] = detail::mul2(a[r] ^ a[(r + 1) & 3]) ^ a[r] ^ t ^ rk[4 * c + r];
+                });
+            });
+        });
+
+        // last round
+        const uint8_t *rk = roundkeys + 16 * Rounds;
+        detail::loop<Unroll, 16>([&](unsigned i) { tmp[i] = Box::sub(s[shift(i)]) ^ rk[i]; });
+        detail::loop<Unroll, 16>([&](unsigned i) { ciphertext[i] = tmp[i]; });
+    }
+
+    static void decrypt_bytes(const uint8_t *roundkeys, const uint8_t *ciphertext, uint8_t *plaintext) {
+        uint8_t s[16], tmp[16];
+
+        // first round: AddRoundKey, InvShiftRows + InvSubBytes
+        const uint8_t *rk = roundkeys + 16 * Rounds;
+        detail::loop<Unroll, 16>([&](unsigned i) { tmp[i] = ciphertext[i] ^ rk[i]; });
+        detail::loop<Unroll, 16>([&](unsigned i) { s[i] = Box::inv_sub(tmp[inv_shift(i)]); });
+
+        // Rounds - 1 full rounds: AddRoundKey + InvMixColumns, then InvShiftRows + InvSubBytes
+        detail::loop<Unroll, Rounds - 1>([&](unsigned k) {
+            const uint8_t *rkj = roundkeys + 16 * (Rounds - 1 - k);
+            detail::loop<Unroll, 4>([&](unsigned c) {
+                uint8_t a[4], t, u, v;
+                detail::loop<Unroll, 4>([&](unsigned r) { a[r] = s[4 * c + r] ^ rkj[4 * c + r]; });
+                t = a[0] ^ a[1] ^ a[2] ^ a[3];
+                u = detail::mul2(detail::mul2(a[0] ^ a[2]));
+                v = detail::mul2(detail::mul2(a[1] ^ a[3]));
+                a[0] ^= u;
+                a[1] ^= v;
+                a[2] ^= u;
+                a[3] ^= v;
+                detail::loop<Unroll, 4>([&](unsigned r) {
+                    tmp[4 * c + r] = detail::mul2(a[r] ^ a[(r + 1) & 3]) ^ a[r] ^ t;
+                });
+            });
+            detail::loop<Unroll, 16>([&](unsigned i) { s[i] = Box::inv_sub(tmp[inv_shift(i)]); });
+        });
+
+        // last AddRoundKey
+        detail::loop<Unroll, 16>([&](unsigned i) { plaintext[i] = s[i] ^ roundkeys[i]; });
+    }
+
+    static AES_TPL_INLINE uint32_t sub_shift_word(uint32_t w0, uint32_t w1, uint32_t w2, uint32_t w3) {
+        return (uint32_t)Box::sub(w0 & 0xff) ^ ((uint32_t)Box::sub((w1 >> 8) & 0xff) << 8) ^
+               ((uint32_t)Box::sub((w2 >> 16) & 0xff) << 16) ^ ((uint32_t)Box::sub(w3 >> 24) << 24);
+    }
+
+    static AES_TPL_INLINE uint32_t inv_sub_shift_word(uint32_t w0, uint32_t w1, uint32_t w2, uint32_t w3) {
+        return (uint32_t)Box::inv_sub(w0 & 0xff) ^ ((uint32_t)Box::inv_sub((w1 >> 8) & 0xff) << 8) ^
+               ((uint32_t)Box::inv_sub((w2 >> 16) & 0xff) << 16) ^ ((uint32_t)Box::inv_sub(w3 >> 24) << 24);
+    }
+
+    static void encrypt_words(const uint8_t *roundkeys, const uint8_t *plaintext, uint8_t *ciphertext) {
+        uint32_t s[4], t[4];
+
+        detail::loop<Unroll, 4>([&](unsigned c) {
+            s[c] = detail::load_word(plaintext + 4 * c) ^ detail::load_word(roundkeys + 4 * c);
+        });
+        detail::loop<Unroll, Rounds - 1>([&](unsigned j) {
+            const uint8_t *rk = roundkeys + 16 * (j + 1);
+            detail::loop<Unroll, 4>([&](unsigned c) {
+                t[c] = sub_shift_word(s[c], s[(c + 1) & 3], s[(c + 2) & 3], s[(c + 3) & 3]);
+            });
+            detail::loop<Unroll, 4>([&](unsigned c) {
+                s[c] = detail::mix_column_word(t[c]) ^ detail::load_word(rk + 4 * c);
+            });
+        });
+        const uint8_t *rk = roundkeys + 16 * Rounds;
+        detail::loop<Unroll, 4>([&](unsigned c) {
+            t[c] = sub_shift_word(s[c], s[(c + 1) & 3], s[(c + 2) & 3], s[(c + 3) & 3]) ^ detail::load_word(rk + 4 * c);
+        });
+        detail::loop<Unroll, 4>([&](unsigned c) { detail::store_word(ciphertext + 4 * c, t[c]); });
+    }
+
+    static void decrypt_words(const uint8_t *roundkeys, const uint8_t *ciphertext, uint8_t *plaintext) {
+        uint32_t s[4], t[4];
+
+        const uint8_t *rk = roundkeys + 16 * Rounds;
+        detail::loop<Unroll, 4>([&](unsigned c) {
+            s[c] = detail::load_word(ciphertext + 4 * c) ^ detail::load_word(rk + 4 * c);
+        });
+        detail::loop<Unroll, 4>([&](unsigned c) {
+            t[c] = inv_sub_shift_word(s[c], s[(c + 3) & 3], s[(c + 2) & 3], s[(c + 1) & 3]);
+        });
+        detail::loop<Unroll, Rounds - 1>([&](unsigned k) {
+            const uint8_t *rkj = roundkeys + 16 * (Rounds - 1 - k);
+            detail::loop<Unroll, 4>([&](unsigned c) {
+                uint32_t w = t[c] ^ detail::load_word(rkj + 4 * c);
+                s[c] = detail::mix_column_word(w ^ detail::xtime_word(detail::xtime_word(w ^ detail::rotr32(w, 16))));
+            });
+            detail::loop<Unroll, 4>([&](unsigned c) {
+                t[c] = inv_sub_shift_word(s[c], s[(c + 3) & 3], s[(c + 2) & 3], s[(c + 1) & 3]);
+            });
+        });
+        detail::loop<Unroll, 4>([&](unsigned c) {
+            detail::store_word(plaintext + 4 * c, t[c] ^ detail::load_word(roundkeys + 4 * c));
+        });
+    }
+};
+
+/*
+ * The points the Req folders were edited by hand into
+ */
+using Baseline = Aes<10, SboxStorage::Ram,   4,          StateLayout::Bytes>;  // Req1: byte loops, MixColumns rows spelled out
+using Progmem  = Aes<10, SboxStorage::Flash, 4,          StateLayout::Bytes>;  // Req3: S-boxes in flash
+using Rolled   = Aes<10, SboxStorage::Ram,   1,          StateLayout::Bytes>;  // Req4: every loop rolled, smallest .text
+using Unrolled = Aes<10, SboxStorage::Ram,   FullUnroll, StateLayout::Bytes>;  // Req5: straight-line rounds, fastest
+using Words    = Aes<10, SboxStorage::Ram,   1,          StateLayout::Words>;  // aes_encrypt_128_word
+
+} // namespace aes
+
+#undef AES_TPL_INLINE
+#endif
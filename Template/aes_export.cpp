@@ -0,0 +1,50 @@
+/*
+ * aes_export.cpp
+ *
+ * Exports one instantiation of aes::Aes under the C entry points of the
+ * Req projects, so that it replaces their aes_encrypt.c, aes_decrypt.c and
+ * aes_schedule.c. Select it with -DAES_PRESET=... in the project symbols.
+ *
+ */
+#include <stdint.h>
+#include "aes.hpp"
+
+#define AES_PRESET_BASELINE 0   // Req1
+#define AES_PRESET_PROGMEM  1   // Req3
+#define AES_PRESET_ROLLED   2   // Req4
+#define AES_PRESET_UNROLLED 3   // Req5
+#define AES_PRESET_WORDS    4   // word-state SWAR rounds
+
+#ifndef AES_PRESET
+#define AES_PRESET          AES_PRESET_BASELINE
+#endif
+
+#if AES_PRESET == AES_PRESET_PROGMEM
+using Engine = aes::Progmem;
+#elif AES_PRESET == AES_PRESET_ROLLED
+using Engine = aes::Rolled;
+#elif AES_PRESET == AES_PRESET_UNROLLED
+using Engine = aes::Unrolled;
+#elif AES_PRESET == AES_PRESET_WORDS
+using Engine = aes::Words;
+#else
+using Engine = aes::Baseline;
+#endif
+
+static_assert(Engine::rounds == 10, "the exported entry points are the AES-128 ones");
+
+extern "C" {
+
+void aes_key_schedule_128(const uint8_t *key, uint8_t *roundkeys) {
+    Engine::key_schedule(key, roundkeys);
+}
+
+void aes_encrypt_128(uint8_t *roundkeys, uint8_t *plaintext, uint8_t *ciphertext) {
+    Engine::encrypt(roundkeys, plaintext, ciphertext);
+}
+
+void aes_decrypt_128(uint8_t *roundkeys, uint8_t *ciphertext, uint8_t *plaintext) {
+    Engine::decrypt(roundkeys, ciphertext, plaintext);
+}
+
+}
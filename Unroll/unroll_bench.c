@@ -0,0 +1,190 @@
+/*
+ * unroll_bench.c
+ *
+ * Cycle counts of one key schedule, one encryption and one decryption, for
+ * unroll_tune.py. Replaces main.c of the project under test and prints
+ *
+ *   AESCYC ks=<n> enc=<n> dec=<n> ok=<0|1>
+ *
+ * ok is the FIPS-197 C.1 known-answer test, so a variant the compiler got
+ * wrong is never reported as fast.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include AES_TYPES_HEADER
+#include "aes_decrypt.h"
+#include "aes_encrypt.h"
+#include "aes_schedule.h"
+
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+/*
+ * Timer1 at clk/1, overflows counted in the ISR. The stub and the call
+ * overhead are measured once and subtracted.
+ */
+static volatile uint16_t overflows;
+
+ISR(TIMER1_OVF_vect) {
+    ++overflows;
+}
+
+static void cycles_init(void) {
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+    TIMSK1 = _BV(TOIE1);
+    sei();
+}
+
+static uint32_t cycles(void) {
+    uint16_t hi, lo;
+
+    cli();
+    lo = TCNT1;
+    hi = overflows;
+    if ((TIFR1 & _BV(TOV1)) && lo < 0x8000) {
+        ++hi;
+    }
+    sei();
+    return ((uint32_t)hi << 16) | lo;
+}
+
+static int uart_putchar(char c, FILE *stream) {
+    while (!(UCSR0A & _BV(UDRE0))) {
+    }
+    UDR0 = c;
+    return 0;
+}
+
+static FILE uart_out = FDEV_SETUP_STREAM(uart_putchar, NULL, _FDEV_SETUP_WRITE);
+
+static void output_init(void) {
+    UCSR0B = _BV(TXEN0);
+    stdout = &uart_out;
+}
+
+static void done(void) {
+    // simavr stops on sleep with interrupts off
+    cli();
+    sleep_cpu();
+}
+
+#elif defined(__ARM_ARCH)
+/*
+ * DWT cycle counter of Cortex-M3/M4. Needs a runner that models it (or real
+ * hardware with semihosting), qemu reads it as 0.
+ */
+#define DEMCR       (*(volatile uint32_t *)0xe000edfcU)
+#define DWT_CTRL    (*(volatile uint32_t *)0xe0001000U)
+#define DWT_CYCCNT  (*(volatile uint32_t *)0xe0001004U)
+
+static void cycles_init(void) {
+    DEMCR |= 0x01000000U;
+    DWT_CYCCNT = 0U;
+    DWT_CTRL |= 1U;
+}
+
+static uint32_t cycles(void) {
+    return DWT_CYCCNT;
+}
+
+static void output_init(void) {
+}
+
+static void done(void) {
+}
+
+#else
+/*
+ * Host dry run: nanoseconds instead of cycles, enough to check the tuner.
+ */
+#include <time.h>
+
+static void cycles_init(void) {
+}
+
+static uint32_t cycles(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000UL + ts.tv_nsec);
+}
+
+static void output_init(void) {
+}
+
+static void done(void) {
+}
+#endif
+
+#define RUNS    8   // best of, against interrupts and warm-up
+
+static const uint8_t key[AES_BLOCK_SIZE] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+static const uint8_t plain[AES_BLOCK_SIZE] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+};
+static const uint8_t cipher[AES_BLOCK_SIZE] = {
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+    0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a,
+};
+
+static uint8_t roundkeys[AES_ROUND_KEY_SIZE];
+static uint8_t in[AES_BLOCK_SIZE];
+static uint8_t out[AES_BLOCK_SIZE];
+
+static void stub(void) {
+}
+
+static void run_ks(void) {
+    aes_key_schedule_128(key, roundkeys);
+}
+
+static void run_enc(void) {
+    aes_encrypt_128(roundkeys, in, out);
+}
+
+static void run_dec(void) {
+    aes_decrypt_128(roundkeys, out, in);
+}
+
+static uint32_t best(void (*fn)(void)) {
+    uint32_t t, min = 0xffffffffUL;
+    uint8_t i;
+
+    for (i = 0; i < RUNS; ++i) {
+        t = cycles();
+        fn();
+        t = cycles() - t;
+        if (t < min) {
+            min = t;
+        }
+    }
+    return min;
+}
+
+int main(void) {
+    uint32_t overhead, ks, enc, dec;
+    int ok;
+
+    output_init();
+    cycles_init();
+
+    memcpy(in, plain, sizeof(in));
+    overhead = best(stub);
+    ks = best(run_ks) - overhead;
+    enc = best(run_enc) - overhead;
+    ok = memcmp(out, cipher, sizeof(out)) == 0;
+    dec = best(run_dec) - overhead;
+    ok = ok && memcmp(in, plain, sizeof(in)) == 0;
+
+    printf("AESCYC ks=%lu enc=%lu dec=%lu ok=%d\n", (unsigned long)ks, (unsigned long)enc,
+           (unsigned long)dec, ok);
+    done();
+    return 0;
+}
@@ -0,0 +1,328 @@
+#!/usr/bin/env python3
+"""
+unroll_tune.py
+
+Build-time unroll-factor tuner for the AES projects. Every for loop in
+aes_encrypt.c, aes_decrypt.c and aes_schedule.c gets a "#pragma GCC unroll N"
+in a generated copy of the sources. The variants are built with the target
+compiler and run in a simulator under unroll_bench.c, and the tuner reports
+the Pareto front of flash size against cycles.
+
+Trying every combination is out of reach (Req4 has 23 loops), so by default
+each loop is measured alone at every factor with all other loops rolled.
+The front of that additive model is then built and measured for real, and
+only measured points are reported. --exhaustive measures every combination
+of the loops picked with --loops instead.
+
+  python3 unroll_tune.py --target avr                      # Req4, simavr
+  python3 unroll_tune.py --target arm --run "..."          # MISRA project
+  python3 unroll_tune.py --target host                     # dry run with gcc
+  python3 unroll_tune.py --target avr --budget 3000 --emit out/
+
+--budget picks the fastest measured variant that fits, --emit writes its
+sources with the pragmas in place, ready to replace the project files.
+"""
+import argparse
+import itertools
+import os
+import re
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(HERE)
+TUNED = ["aes_encrypt.c", "aes_decrypt.c", "aes_schedule.c"]
+
+TARGETS = {
+    "avr": {
+        "src": os.path.join(ROOT, "Req4", "Req4", "Req4"),
+        "cc": "avr-gcc",
+        "cflags": "-mmcu=atmega328p -Os -DF_CPU=16000000UL -std=gnu99",
+        "size": "avr-size",
+        "run": "simavr -m atmega328p -f 16000000 {elf}",
+    },
+    "arm": {
+        "src": os.path.join(ROOT, "MISRA Rules", "Misra"),
+        "cc": "arm-none-eabi-gcc",
+        "cflags": "-mcpu=cortex-m4 -mthumb -Os -std=gnu99 --specs=rdimon.specs",
+        "size": "arm-none-eabi-size",
+        "run": "qemu-system-arm -M netduinoplus2 -nographic -semihosting -kernel {elf}",
+    },
+    "host": {
+        "src": os.path.join(ROOT, "Req4", "Req4", "Req4"),
+        "cc": "gcc",
+        "cflags": "-O2 -std=gnu99",
+        "size": "size",
+        "run": "{elf}",
+    },
+}
+
+
+class Loop:
+    def __init__(self, file, index, offset, line, header):
+        self.file = file
+        self.index = index
+        self.offset = offset
+        self.line = line
+        self.header = header
+        self.id = "%s.%d" % (file[len("aes_"):-len(".c")], index)
+
+
+def find_loops(path, name):
+    """Offsets of the for keywords outside comments and strings."""
+    text = open(path, newline="").read()
+    loops = []
+    i, n = 0, len(text)
+    while i < n:
+        if text.startswith("//", i):
+            i = text.find("\n", i)
+            i = n if i < 0 else i
+        elif text.startswith("/*", i):
+            i = text.find("*/", i + 2)
+            i = n if i < 0 else i + 2
+        elif text[i] in "\"'":
+            q, i = text[i], i + 1
+            while i < n and text[i] != q:
+                i += 2 if text[i] == "\\" else 1
+            i += 1
+        elif (text.startswith("for", i) and (i == 0 or not (text[i - 1].isalnum() or text[i - 1] == "_"))
+              and re.match(r"for\s*\(", text[i:i + 16])):
+            end = text.find(")", i)
+            depth, j = 0, i
+            while j < n:
+                if text[j] == "(":
+                    depth += 1
+                elif text[j] == ")":
+                    depth -= 1
+                    if depth == 0:
+                        end = j
+                        break
+                j += 1
+            header = " ".join(text[i:end + 1].split())
+            loops.append(Loop(name, len(loops), i, text.count("\n", 0, i) + 1, header))
+            i = end + 1
+        else:
+            i += 1
+    return text, loops
+
+
+def emit(src, loops, config, dst):
+    """Copy src to dst with "#pragma GCC unroll" before every loop in config."""
+    os.makedirs(dst, exist_ok=True)
+    for name in os.listdir(src):
+        p = os.path.join(src, name)
+        if os.path.isfile(p) and (name.endswith(".h") or (name.endswith(".c") and name != "main.c")):
+            shutil.copyfile(p, os.path.join(dst, name))
+    for name in TUNED:
+        text, found = find_loops(os.path.join(src, name), name)
+        eol = "\r\n" if "\r\n" in text else "\n"
+        for loop in reversed(found):
+            factor = config.get(loop.id)
+            if factor is None:
+                continue
+            start = text.rfind("\n", 0, loop.offset) + 1
+            indent = text[start:loop.offset]
+            if indent.strip():
+                # "} for (" and the like, the pragma needs a line of its own
+                text = text[:loop.offset] + eol + "#pragma GCC unroll %d" % factor + eol + text[loop.offset:]
+            else:
+                text = text[:start] + "#pragma GCC unroll %d" % factor + eol + text[start:]
+        with open(os.path.join(dst, name), "w", newline="") as f:
+            f.write(text)
+
+
+class Runner:
+    def __init__(self, args):
+        self.args = args
+        self.work = tempfile.mkdtemp(prefix="unroll_")
+        self.count = 0
+        self.cache = {}
+        types = "std_types.h" if os.path.exists(os.path.join(args.src, "std_types.h")) else None
+        self.types = '-DAES_TYPES_HEADER="std_types.h"' if types else "-DAES_TYPES_HEADER=<stdint.h>"
+
+    def sh(self, cmd, cwd):
+        p = subprocess.run(cmd, cwd=cwd, shell=True, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                           universal_newlines=True, timeout=self.args.timeout)
+        return p.returncode, p.stdout
+
+    def measure(self, config):
+        """(flash bytes, ks, enc, dec) of one configuration, or None if it fails the known-answer test."""
+        key = tuple(sorted(config.items()))
+        if key in self.cache:
+            return self.cache[key]
+        self.count += 1
+        d = os.path.join(self.work, "v%d" % self.count)
+        emit(self.args.src, self.loops, config, d)
+        shutil.copyfile(os.path.join(HERE, "unroll_bench.c"), os.path.join(d, "unroll_bench.c"))
+        objs = []
+        for name in sorted(os.listdir(d)):
+            if name.endswith(".c"):
+                cmd = "%s %s %s -I. -c %s -o %s.o" % (self.args.cc, self.args.cflags, shlex.quote(self.types),
+                                                       name, name[:-2])
+                rc, out = self.sh(cmd, d)
+                if rc:
+                    sys.exit("build failed in %s:\n%s" % (d, out))
+                objs.append(name[:-2] + ".o")
+        rc, out = self.sh("%s %s %s -o bench.elf" % (self.args.cc, self.args.cflags, " ".join(objs)), d)
+        if rc:
+            sys.exit("link failed in %s:\n%s" % (d, out))
+
+        # flash taken by the tuned files: text + data (initialised data is copied from flash)
+        rc, out = self.sh("%s %s" % (self.args.size, " ".join(n[:-2] + ".o" for n in TUNED)), d)
+        flash = 0
+        for line in out.splitlines()[1:]:
+            cols = line.split()
+            flash += int(cols[0]) + int(cols[1])
+
+        rc, out = self.sh(self.args.run.format(elf=os.path.join(d, "bench.elf")), d)
+        m = re.search(r"AESCYC ks=(\d+) enc=(\d+) dec=(\d+) ok=(\d)", out)
+        if not m:
+            sys.exit("no AESCYC line from the runner in %s:\n%s" % (d, out))
+        if m.group(4) != "1":
+            result = None
+        else:
+            result = (flash, int(m.group(1)), int(m.group(2)), int(m.group(3)))
+        self.cache[key] = result
+        if not self.args.keep:
+            shutil.rmtree(d, ignore_errors=True)
+        return result
+
+
+def cost(r, w):
+    return w[0] * r[1] + w[1] * r[2] + w[2] * r[3]
+
+
+def pareto(points):
+    """points: (flash, cycles, payload). Keeps those no other point beats on both."""
+    front = []
+    for p in sorted(points, key=lambda p: (p[0], p[1])):
+        if not front or p[1] < front[-1][1]:
+            front.append(p)
+    return front
+
+
+def config_str(config):
+    items = ["%s=%d" % (k, v) for k, v in sorted(config.items()) if v != 1]
+    return " ".join(items) if items else "all rolled"
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--target", choices=sorted(TARGETS), default="avr")
+    ap.add_argument("--src", help="project folder with aes_*.c (default depends on --target)")
+    ap.add_argument("--cc")
+    ap.add_argument("--cflags")
+    ap.add_argument("--size", help="Berkeley-format size tool")
+    ap.add_argument("--run", help="runner command, {elf} is replaced by the image")
+    ap.add_argument("--factors", default="1,2,4,16", help="unroll factors to try, 1 keeps a loop rolled")
+    ap.add_argument("--weights", default="1,1,1", help="weights of key schedule, encryption, decryption cycles")
+    ap.add_argument("--loops", help="comma separated loop ids to tune, the others stay rolled")
+    ap.add_argument("--exhaustive", action="store_true", help="measure every combination of the tuned loops")
+    ap.add_argument("--budget", type=int, help="flash budget in bytes for --emit")
+    ap.add_argument("--emit", help="write the chosen variant's sources here")
+    ap.add_argument("--list", action="store_true", help="only list the loops")
+    ap.add_argument("--keep", action="store_true", help="keep the build folders")
+    ap.add_argument("--timeout", type=int, default=120)
+    args = ap.parse_args()
+
+    t = TARGETS[args.target]
+    for k in ("src", "cc", "cflags", "size", "run"):
+        if getattr(args, k) is None:
+            setattr(args, k, t[k])
+    factors = sorted({int(f) for f in args.factors.split(",")} | {1})
+    weights = [float(x) for x in args.weights.split(",")]
+
+    loops = []
+    for name in TUNED:
+        loops += find_loops(os.path.join(args.src, name), name)[1]
+    if args.list:
+        for loop in loops:
+            print("%-12s %s:%-4d %s" % (loop.id, loop.file, loop.line, loop.header))
+        return
+    if args.loops:
+        wanted = set(args.loops.split(","))
+        unknown = wanted - {l.id for l in loops}
+        if unknown:
+            sys.exit("unknown loops: %s (see --list)" % ", ".join(sorted(unknown)))
+        tuned = [l for l in loops if l.id in wanted]
+    else:
+        tuned = loops
+
+    runner = Runner(args)
+    runner.loops = loops
+    rolled = {l.id: 1 for l in loops}
+
+    base = runner.measure(rolled)
+    if base is None:
+        sys.exit("the all-rolled variant fails the known-answer test")
+    default = runner.measure({})
+    print("%d loops, factors %s" % (len(loops), ",".join(map(str, factors))))
+    print("all rolled        %6d bytes  ks %7d  enc %7d  dec %7d" % base)
+    if default is not None:
+        print("compiler default  %6d bytes  ks %7d  enc %7d  dec %7d" % default)
+
+    measured = []
+    if args.exhaustive:
+        for combo in itertools.product(factors, repeat=len(tuned)):
+            config = dict(rolled)
+            config.update({l.id: f for l, f in zip(tuned, combo)})
+            r = runner.measure(config)
+            if r is not None:
+                measured.append((r[0], cost(r, weights), (config, r)))
+    else:
+        # one loop at a time against the all-rolled base
+        options = []
+        for loop in tuned:
+            opts = [(0, 0.0, 1)]
+            for f in factors[1:]:
+                config = dict(rolled)
+                config[loop.id] = f
+                r = runner.measure(config)
+                if r is None:
+                    print("  %s at %d fails the known-answer test, skipped" % (loop.id, f))
+                    continue
+                opts.append((r[0] - base[0], cost(r, weights) - cost(base, weights), f))
+            options.append((loop, opts))
+
+        # front of the additive model, one loop at a time
+        model = [(base[0], cost(base, weights), {})]
+        for loop, opts in options:
+            merged = []
+            for flash, cyc, picked in model:
+                for dflash, dcyc, f in opts:
+                    p = dict(picked)
+                    p[loop.id] = f
+                    merged.append((flash + dflash, cyc + dcyc, p))
+            model = pareto(merged)
+
+        for _, _, picked in model:
+            config = dict(rolled)
+            config.update(picked)
+            r = runner.measure(config)
+            if r is not None:
+                measured.append((r[0], cost(r, weights), (config, r)))
+        measured.append((base[0], cost(base, weights), (rolled, base)))
+
+    front = pareto(measured)
+    print("\nPareto front, %d variants built:" % runner.count)
+    print("%6s %8s %7s %7s %7s  %s" % ("flash", "cost", "ks", "enc", "dec", "unrolled loops"))
+    for flash, c, (config, r) in front:
+        print("%6d %8.0f %7d %7d %7d  %s" % (flash, c, r[1], r[2], r[3], config_str(config)))
+
+    if args.emit:
+        fits = [p for p in front if args.budget is None or p[0] <= args.budget]
+        if not fits:
+            sys.exit("nothing fits in %d bytes" % args.budget)
+        flash, c, (config, r) = min(fits, key=lambda p: p[1])
+        emit(args.src, loops, config, args.emit)
+        print("\nwrote %s (%d bytes, cost %.0f)" % (args.emit, flash, c))
+
+    if not args.keep:
+        shutil.rmtree(runner.work, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    main()